@@ -969,7 +969,7 @@ OpFailStatus MeosSQL::SyncUpdate(oEvent *oe)
   try {
     con->query().exec("DELETE FROM oCard");
     {
-      list<oCard>::iterator it = oe->Cards.begin();
+      oCardList::iterator it = oe->Cards.begin();
       while (it != oe->Cards.end()) {
         if (!it->isRemoved() && syncUpdate(&*it, true) == opStatusFail)
           return opStatusFail;
@@ -1015,7 +1015,7 @@ OpFailStatus MeosSQL::SyncUpdate(oEvent *oe)
     }
     con->query().exec("DELETE FROM oRunner");
     {
-      list<oRunner>::iterator it = oe->Runners.begin();
+      oRunnerList::iterator it = oe->Runners.begin();
       while (it != oe->Runners.end()) {
         if (!it->isRemoved() && syncUpdate(&*it, true) == opStatusFail)
           return opStatusFail;
@@ -1025,7 +1025,7 @@ OpFailStatus MeosSQL::SyncUpdate(oEvent *oe)
 
     con->query().exec("DELETE FROM oTeam");
     {
-      list<oTeam>::iterator it = oe->Teams.begin();
+      oTeamList::iterator it = oe->Teams.begin();
       while (it != oe->Teams.end()) {
         if (!it->isRemoved() && syncUpdate(&*it, true) == opStatusFail)
           return opStatusFail;
@@ -1035,7 +1035,7 @@ OpFailStatus MeosSQL::SyncUpdate(oEvent *oe)
 
     con->query().exec("DELETE FROM oPunch");
     {
-      list<oFreePunch>::iterator it = oe->punches.begin();
+      oFreePunchList::iterator it = oe->punches.begin();
       while (it != oe->punches.end()) {
         if (!it->isRemoved() && syncUpdate(&*it, true) == opStatusFail)
           return opStatusFail;
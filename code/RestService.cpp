@@ -140,6 +140,10 @@ void RestService::status(gdioutput &gdi) {
     gdi.addString("", 0, "Antal förfrågningar: X.#" + itos(rs.numRequests));
     gdi.addString("", 0, "Genomsnittlig svarstid: X ms.#" + itos(rs.averageResponseTime));
     gdi.addString("", 0, "Längsta svarstid: X ms.#" + itos(rs.maxResponseTime));
+    for (auto &ep : rs.endpoints) {
+      gdi.addString("", 0, "X: Y från cache, Z beräknade, W oförändrade#" + ep.endpoint + "#" + itos(ep.hits) +
+                            "#" + itos(ep.misses) + "#" + itos(ep.notModified));
+    }
 
     gdi.dropLine(0.6);
     gdi.addButton("Update", "Uppdatera").setHandler(this);
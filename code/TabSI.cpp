@@ -703,11 +703,13 @@ int TabSI::siCB(gdioutput& gdi, GuiEventType type, BaseInfo * data) {
       string filter = lbi.data < filterDate.size() ? gdi.narrow(filterDate[lbi.data]) : "";
 
       gdi.restore("Help");
+      vector<oEvent::FreePunchInput> batch;
       for (size_t k = 0; k < punches.size(); k++) {
         if (dofilter && filter != punches[k].date)
           continue;
-        oe->addFreePunch(punches[k].time, type, 0, punches[k].card, true, true);
+        batch.push_back({ punches[k].time, type, 0, punches[k].card, true });
       }
+      oe->addFreePunches(batch, true);
       punches.clear();
       if (origin == 1) {
         TabRunner& tc = dynamic_cast<TabRunner&>(*gdi.getTabs().get(TRunnerTab));
@@ -3018,12 +3020,13 @@ void TabSI::processInsertCard(const SICard& sic)
   if (sic.FinishPunch.Code != -1)
     card->addPunch(oPunch::PunchFinish, sic.FinishPunch.Time, 0, sic.FinishPunch.Code, origin);
 
-  //Update to SQL-source
-  card->synchronize();
-
   if (runner) {
     vector<pair<int, pControl>> mp;
-    runner->addCard(card, mp);
+    runner->addCard(card, mp); // Synchronizes the card
+  }
+  else {
+    //Update to SQL-source
+    card->synchronize();
   }
 }
 
@@ -3213,7 +3216,6 @@ bool TabSI::processCard(gdioutput& gdi, pRunner runner, const SICard& csic, bool
     if (!hasFinish)
       rout.warnings += lang.tl(L"Målstämpling saknas.");
 
-    card->synchronize();
     runner->addCard(card, rout.MP);
     runner->synchronize(true);
     runner->hasManuallyUpdatedTimeStatus();
@@ -5799,9 +5801,7 @@ public:
         oe->getRunners(selectedClasses, rList, true);
                 
         sort(rList.begin(), rList.end(), [](const pRunner& a, const pRunner& b) -> bool {
-          return CompareString(LOCALE_USER_DEFAULT, 0,
-                               a->getName().c_str(), a->getName().length(),
-                               b->getName().c_str(), b->getName().length()) == CSTR_LESS_THAN; });
+          return a->getNameKey() < b->getNameKey(); });
 
         vector<pair<wstring, size_t>> rItem;
         for (pRunner r : rList) {
@@ -28,6 +28,7 @@
 #include "meos.h"
 #include "TimeStamp.h"
 #include <algorithm>
+#include <atomic>
 #include "meos_util.h"
 
 //////////////////////////////////////////////////////////////////////
@@ -47,13 +48,20 @@ TimeStamp::~TimeStamp()
 
 }
 
+unsigned int TimeStamp::nextChangeSerial() {
+  static std::atomic<unsigned int> serial(0);
+  return ++serial;
+}
+
 void TimeStamp::update(TimeStamp &ts)
 {
   Time=max(Time, ts.Time);
+  changeSerial = nextChangeSerial();
 }
 
 void TimeStamp::update()
 {
+  changeSerial = nextChangeSerial();
   SYSTEMTIME st;
   GetLocalTime(&st);
 
@@ -155,6 +163,7 @@ void TimeStamp::setStamp(const string &s)
 {
   if (s.size()<14)
     return;
+  changeSerial = nextChangeSerial();
   SYSTEMTIME st;
   memset(&st, 0, sizeof(st));
 
@@ -36,8 +36,12 @@ using namespace std;
 
 class TimeStamp {
   unsigned int Time;
+  // Increasing number, unique for each modification
+  unsigned int changeSerial = 0;
   mutable string stampCode;
   mutable int stampCodeTime = 0;
+
+  static unsigned int nextChangeSerial();
 public:
   void setStamp(const string &s);
   const string &getStamp() const;
@@ -49,6 +53,8 @@ public:
   string getStampStringN() const;
   int getAge() const;
   unsigned int getModificationTime() const {return Time;}
+  /** A number that changes with each modification (unlike the time, which has a resolution of seconds).*/
+  unsigned int getChangeSerial() const {return changeSerial;}
 
   void update();
   void update(TimeStamp &ts);
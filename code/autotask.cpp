@@ -203,6 +203,10 @@ void AutoTask::synchronize(const vector<gdioutput *> &windows) {
 }
 
 void AutoTask::advancePunchInformation(const vector<gdioutput *> &windows) {
+  // Allow new notifications even if the queue is not read now
+  if (oe.hasDirectSocket())
+    oe.getDirectSocket().notificationHandled();
+
   uint64_t tic = GetTickCount64();
   DWORD avg = getAvgSynchTime();
   //OutputDebugString(("Direct Update Time: " + itos(avg)).c_str());
@@ -131,6 +131,14 @@ void Download::initInternet() {
   InternetSetOption(hInternet, INTERNET_OPTION_SEND_TIMEOUT, &dwTimeOut, sizeof(DWORD));
 }
 
+void Download::setTimeout(DWORD timeOut) {
+  if (!hInternet)
+    return;
+  InternetSetOption(hInternet, INTERNET_OPTION_CONNECT_TIMEOUT, &timeOut, sizeof(DWORD));
+  InternetSetOption(hInternet, INTERNET_OPTION_RECEIVE_TIMEOUT, &timeOut, sizeof(DWORD));
+  InternetSetOption(hInternet, INTERNET_OPTION_SEND_TIMEOUT, &timeOut, sizeof(DWORD));
+}
+
 void Download::downloadFile(const wstring &url, const wstring &file, const vector< pair<wstring, wstring> > &headers)
 {
   if (hURL || !hInternet)
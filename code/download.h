@@ -74,6 +74,8 @@ public:
   void endDownload();
   void downloadFile(const wstring &url, const wstring &file, const vector< pair<wstring, wstring> > &headers);
   void initInternet();
+  /** Set connect, send and receive timeouts of the session (ms). Call after initInternet.*/
+  void setTimeout(DWORD timeOut);
   void shutDown();
   bool createDownloadThread();
   void downLoadNoThread() {initThread();}
@@ -22,12 +22,14 @@
 #include "stdafx.h"
 
 #include <algorithm>
+#include <chrono>
 #include "generalresult.h"
 #include "oEvent.h"
 #include "meos_util.h"
 #include "oListInfo.h"
 #include "meosexception.h"
 #include "localizer.h"
+#include "gdifonts.h"
 #include "xmlparser.h"
 
 extern gdioutput *gdi_main;
@@ -376,22 +378,14 @@ void GeneralResult::calculateIndividualResults(vector<oRunner *> &runners,
           runners[k]->tmpResult.startTime = runners[k]->getStartTime();
       }
 
-      prepareCalculations(*runners[k], classResult);
-      runners[k]->tmpResult.runningTime = deduceTime(*runners[k], runners[k]->tmpResult.startTime);
-      runners[k]->tmpResult.status = deduceStatus(*runners[k]);
-      runners[k]->tmpResult.points = deducePoints(*runners[k]);
-
-      runnerScore[k].score = score(*runners[k], runners[k]->tmpResult.status,
-                                   runners[k]->tmpResult.runningTime,
-                                   runners[k]->tmpResult.points, false);
-
-      storeOutput(runners[k]->tmpResult.outputTimes,
-                  runners[k]->tmpResult.outputNumbers);
-
       runnerScore[k].tr = runners[k];
-
     }
 
+    vector<pair<int, int>> scores;
+    calculateRunners(runners, classResult, scores);
+    for (size_t k = 0; k < runners.size(); k++)
+      runnerScore[k].score = scores[k];
+
     ::sort(runnerScore.begin(), runnerScore.end());
     int place = 1;
     int iPlace = 1;
@@ -475,6 +469,21 @@ void GeneralResult::prepareCalculations(oRunner &runner, bool classResult) const
 void GeneralResult::storeOutput(vector<int> &times, vector<int> &numbers) const {
 }
 
+void GeneralResult::calculateRunners(const vector<pRunner> &runners, bool classResult, vector<pair<int, int>> &scores) const {
+  scores.resize(runners.size());
+  for (size_t k = 0; k < runners.size(); k++) {
+    oRunner &r = *runners[k];
+    prepareCalculations(r, classResult);
+    r.tmpResult.runningTime = deduceTime(r, r.tmpResult.startTime);
+    r.tmpResult.status = deduceStatus(r);
+    r.tmpResult.points = deducePoints(r);
+
+    scores[k] = score(r, r.tmpResult.status, r.tmpResult.runningTime, r.tmpResult.points, false);
+
+    storeOutput(r.tmpResult.outputTimes, r.tmpResult.outputNumbers);
+  }
+}
+
 pair<int, int> GeneralResult::score(oTeam &team, RunnerStatus st, int rt, int points) const {
   return make_pair((100 * RunnerStatusOrderMap[st] + team.getNumShortening()) * 100000 - points,  + rt);
 }
@@ -660,6 +669,7 @@ map<string, DynamicResult::DynamicMethods> DynamicResult::symb2Method;
 map<DynamicResult::DynamicMethods, pair<string, string> > DynamicResult::method2SymbName;
 
 DynamicResult::DynamicResult() {
+  parser.setSymbolProvider([this](int key) {computeDeferred(key);});
   builtIn = false;
   readOnly = false;
   isCompiled = false;
@@ -680,6 +690,7 @@ DynamicResult::DynamicResult() {
 }
 
 DynamicResult::DynamicResult(const DynamicResult &resIn) {
+  parser.setSymbolProvider([this](int key) {computeDeferred(key);});
   instanceCount++;
   isCompiled = false;
   name = resIn.name;
@@ -714,6 +725,7 @@ void DynamicResult::operator=(const DynamicResult &resIn) {
     methods[k].source = resIn.methods[k].source;
     methods[k].description = resIn.methods[k].description;
     methods[k].pn = 0;
+    methods[k].program.clear();
   }
 
 }
@@ -744,6 +756,10 @@ const ParseNode *DynamicResult::getMethod(DynamicMethods method) const {
   return methods[method].pn;
 }
 
+int DynamicResult::runMethod(DynamicMethods method) const {
+  return parser.execute(methods[method].program);
+}
+
 const string &DynamicResult::getMethodSource(DynamicMethods method) const {
   return methods[method].source;
 }
@@ -751,7 +767,9 @@ const string &DynamicResult::getMethodSource(DynamicMethods method) const {
 void DynamicResult::setMethodSource(DynamicMethods method, const string &source) {
   methods[method].source = source;
   methods[method].pn = 0;
+  methods[method].program.clear();
   methods[method].pn = parser.parse(source);
+  parser.compile(methods[method].pn, methods[method].program);
 }
 
 RunnerStatus DynamicResult::toStatus(int status) const {
@@ -785,10 +803,10 @@ RunnerStatus DynamicResult::toStatus(int status) const {
 
 pair<int,int> DynamicResult::score(oTeam &team, RunnerStatus st, int time, int points) const {
   if (getMethod(MTScore)) {
-    parser.addSymbol("ComputedTime", time / timeConstSecond);
-    parser.addSymbol("ComputedStatus", st);
-    parser.addSymbol("ComputedPoints", points);
-    return make_pair(0, getMethod(MTScore)->evaluate(parser));
+    parser.addSymbol(symbolSlot[SComputedTime], time / timeConstSecond);
+    parser.addSymbol(symbolSlot[SComputedStatus], st);
+    parser.addSymbol(symbolSlot[SComputedPoints], points);
+    return make_pair(0, runMethod(MTScore));
   }
   else if (getMethodSource(MTScore).empty())
     return GeneralResult::score(team, st, time, points);
@@ -797,7 +815,7 @@ pair<int,int> DynamicResult::score(oTeam &team, RunnerStatus st, int time, int p
 
 RunnerStatus DynamicResult::deduceStatus(oTeam &team) const {
   if (getMethod(MDeduceTStatus))
-    return toStatus(getMethod(MDeduceTStatus)->evaluate(parser));
+    return toStatus(runMethod(MDeduceTStatus));
   else if (getMethodSource(MDeduceTStatus).empty())
     return GeneralResult::deduceStatus(team);
   else throw meosException("Syntax error");
@@ -805,7 +823,7 @@ RunnerStatus DynamicResult::deduceStatus(oTeam &team) const {
 
 int DynamicResult::deduceTime(oTeam &team) const {
   if (getMethod(MDeduceTTime))
-    return getMethod(MDeduceTTime)->evaluate(parser) * timeConstSecond + team.getSubSeconds();
+    return runMethod(MDeduceTTime) * timeConstSecond + team.getSubSeconds();
   else if (getMethodSource(MDeduceTTime).empty())
     return GeneralResult::deduceTime(team);
   else throw meosException("Syntax error");
@@ -813,7 +831,7 @@ int DynamicResult::deduceTime(oTeam &team) const {
 
 int DynamicResult::deducePoints(oTeam &team) const {
   if (getMethod(MDeduceTPoints))
-    return getMethod(MDeduceTPoints)->evaluate(parser);
+    return runMethod(MDeduceTPoints);
   else if (getMethodSource(MDeduceTPoints).empty())
     return GeneralResult::deducePoints(team);
   else throw meosException("Syntax error");
@@ -821,10 +839,10 @@ int DynamicResult::deducePoints(oTeam &team) const {
 
 pair<int,int> DynamicResult::score(oRunner &runner, RunnerStatus st, int time, int points, bool asTeamMember) const {
   if (getMethod(MRScore)) {
-    parser.addSymbol("ComputedTime", time / timeConstSecond);
-    parser.addSymbol("ComputedStatus", st);
-    parser.addSymbol("ComputedPoints", points);
-    return make_pair(0, getMethod(MRScore)->evaluate(parser));
+    parser.addSymbol(symbolSlot[SComputedTime], time / timeConstSecond);
+    parser.addSymbol(symbolSlot[SComputedStatus], st);
+    parser.addSymbol(symbolSlot[SComputedPoints], points);
+    return make_pair(0, runMethod(MRScore));
   }
   else if (getMethodSource(MRScore).empty())
     return GeneralResult::score(runner, st, time, points, asTeamMember);
@@ -833,7 +851,7 @@ pair<int,int> DynamicResult::score(oRunner &runner, RunnerStatus st, int time, i
 
 RunnerStatus DynamicResult::deduceStatus(oRunner &runner) const {
   if (getMethod(MDeduceRStatus))
-    return toStatus(getMethod(MDeduceRStatus)->evaluate(parser));
+    return toStatus(runMethod(MDeduceRStatus));
   else if (getMethodSource(MDeduceRStatus).empty())
     return GeneralResult::deduceStatus(runner);
   else throw meosException("Syntax error");
@@ -841,7 +859,7 @@ RunnerStatus DynamicResult::deduceStatus(oRunner &runner) const {
 
 int DynamicResult::deduceTime(oRunner &runner, int startTime) const {
   if (getMethod(MDeduceRTime))
-    return getMethod(MDeduceRTime)->evaluate(parser) * timeConstSecond + runner.getSubSeconds();
+    return runMethod(MDeduceRTime) * timeConstSecond + runner.getSubSeconds();
   else if (getMethodSource(MDeduceRTime).empty())
     return GeneralResult::deduceTime(runner, startTime);
   else throw meosException("Syntax error");
@@ -849,7 +867,7 @@ int DynamicResult::deduceTime(oRunner &runner, int startTime) const {
 
 int DynamicResult::deducePoints(oRunner &runner) const {
   if (getMethod(MDeduceRPoints))
-    return getMethod(MDeduceRPoints)->evaluate(parser);
+    return runMethod(MDeduceRPoints);
   else if (getMethodSource(MDeduceRPoints).empty())
     return GeneralResult::deducePoints(runner);
   else throw meosException("Syntax error");
@@ -892,6 +910,7 @@ void DynamicResult::clear() {
   parser.clear();
   for (size_t k = 0; k < methods.size(); k++) {
     methods[k].pn = nullptr;
+    methods[k].program.clear();
     methods[k].source.clear();
     methods[k].description.clear();
   }
@@ -937,6 +956,7 @@ void DynamicResult::compile(bool forceRecompile) const {
 
   for (size_t k = 0; k < methods.size(); k++) {
     methods[k].pn = 0;
+    methods[k].program.clear();
   }
   parser.clear();
 
@@ -945,6 +965,7 @@ void DynamicResult::compile(bool forceRecompile) const {
     if (!methods[k].source.empty()) {
       try {
         methods[k].pn = parser.parse(methods[k].source);
+        parser.compile(methods[k].pn, methods[k].program);
       }
       catch (const meosException &ex) {
         if (err.first.empty()) {
@@ -970,6 +991,7 @@ void DynamicResult::getMethodTypes(vector< pair<DynamicMethods, string> > &mt) c
 void DynamicResult::declareSymbols(DynamicMethods m, bool clear) const {
   if (clear)
     parser.clearSymbols();
+  resolveSymbolSlots();
   const bool isRunner = m == MRScore ||
     m == MDeduceRPoints ||
     m == MDeduceRStatus ||
@@ -1143,11 +1165,11 @@ void DynamicResult::prepareCalculations(oEvent &oe,
   oe.calculateTeamResults(*tPtr, total);
 
   declareSymbols(MRScore, true);
+  lazyRunner = nullptr;
+  lazyTeam = nullptr;
+  symbolCost.clear();
   if (teams.size() > 0) {
     declareSymbols(MTScore, false);
-    for (pTeam t : teams)
-      t->resetResultCalcCache();
-
     oe.calculateTeamResults(teams, single);
     oe.calculateTeamResults(teams, total);
   }
@@ -1178,76 +1200,54 @@ void DynamicResult::prepareCommon(oAbstractRunner &runner, bool classResult) con
   int ft = runner.getFinishTime();
   if (st == StatusUnknown && ft > 0)
     st = StatusOK;
-  parser.addSymbol("Status", st);
-  parser.addSymbol("Start", runner.getStartTime() / timeConstSecond);
-  parser.addSymbol("Finish", ft / timeConstSecond);
-  parser.addSymbol("Time", runner.getRunningTime(useComputed) / timeConstSecond);
-  parser.addSymbol("Place", runner.getPlace(false));
-  parser.addSymbol("Points", runner.getRogainingPoints(useComputed, false));
-  parser.addSymbol("PointReduction", runner.getRogainingReduction(useComputed));
-  parser.addSymbol("PointOvertime", runner.getRogainingOvertime(useComputed) / timeConstSecond);
-  parser.addSymbol("PointGross", runner.getRogainingPointsGross(useComputed));
-
-  parser.addSymbol("PointAdjustment", runner.getPointAdjustment());
-  parser.addSymbol("TimeAdjustment", runner.getTimeAdjustment(true) / timeConstSecond);
-
-  parser.addSymbol("TotalStatus", runner.getTotalStatus(false));
-  parser.addSymbol("TotalTime", runner.getTotalRunningTime()/timeConstSecond);
-  parser.addSymbol("TotalPlace", runner.getTotalPlace(false));
-
-  parser.addSymbol("InputStatus", runner.getInputStatus());
-  parser.addSymbol("InputTime", runner.getInputTime() / timeConstSecond);
-  parser.addSymbol("InputPlace", runner.getInputPlace());
-  parser.addSymbol("InputPoints", runner.getInputPoints());
-  parser.addSymbol("Shorten", runner.getNumShortening());
-
-  parser.addSymbol("DataA", runner.getDCI().getInt("DataA"));
-  parser.addSymbol("DataB", runner.getDCI().getInt("DataB"));
+  parser.addSymbol(symbolSlot[SStatus], st);
+  parser.addSymbol(symbolSlot[SStart], runner.getStartTime() / timeConstSecond);
+  parser.addSymbol(symbolSlot[SFinish], ft / timeConstSecond);
+  parser.addSymbol(symbolSlot[STime], runner.getRunningTime(useComputed) / timeConstSecond);
+  parser.addSymbol(symbolSlot[SPlace], runner.getPlace(false));
+  parser.addSymbol(symbolSlot[SPoints], runner.getRogainingPoints(useComputed, false));
+  parser.addSymbol(symbolSlot[SPointReduction], runner.getRogainingReduction(useComputed));
+  parser.addSymbol(symbolSlot[SPointOvertime], runner.getRogainingOvertime(useComputed) / timeConstSecond);
+  parser.addSymbol(symbolSlot[SPointGross], runner.getRogainingPointsGross(useComputed));
+
+  parser.addSymbol(symbolSlot[SPointAdjustment], runner.getPointAdjustment());
+  parser.addSymbol(symbolSlot[STimeAdjustment], runner.getTimeAdjustment(true) / timeConstSecond);
+
+  parser.addSymbol(symbolSlot[STotalStatus], runner.getTotalStatus(false));
+  parser.addSymbol(symbolSlot[STotalTime], runner.getTotalRunningTime()/timeConstSecond);
+  parser.addSymbol(symbolSlot[STotalPlace], runner.getTotalPlace(false));
+
+  parser.addSymbol(symbolSlot[SInputStatus], runner.getInputStatus());
+  parser.addSymbol(symbolSlot[SInputTime], runner.getInputTime() / timeConstSecond);
+  parser.addSymbol(symbolSlot[SInputPlace], runner.getInputPlace());
+  parser.addSymbol(symbolSlot[SInputPoints], runner.getInputPoints());
+  parser.addSymbol(symbolSlot[SShorten], runner.getNumShortening());
+
+  parser.addSymbol(symbolSlot[SDataA], runner.getDCI().getInt("DataA"));
+  parser.addSymbol(symbolSlot[SDataB], runner.getDCI().getInt("DataB"));
 
   pClass cls = runner.getClassRef(true);
   if (cls) {
-    parser.addSymbol("ClassDataA", cls->getDCI().getInt("DataA"));
-    parser.addSymbol("ClassDataB", cls->getDCI().getInt("DataB"));
+    parser.addSymbol(symbolSlot[SClassDataA], cls->getDCI().getInt("DataA"));
+    parser.addSymbol(symbolSlot[SClassDataB], cls->getDCI().getInt("DataB"));
   }
   else {
-    parser.addSymbol("ClassDataA", 0);
-    parser.addSymbol("ClassDataB", 0);
+    parser.addSymbol(symbolSlot[SClassDataA], 0);
+    parser.addSymbol(symbolSlot[SClassDataB], 0);
   }
 
-  vector<RunnerStatus> inst;
-  vector<int> times;
-  vector<int> points;
-  vector<int> places;
-  vector<int> iinst;
-  runner.getInputResults(inst, times, points, places);
-  for (RunnerStatus s : inst)
-    iinst.push_back(s);
-
-  for (int &t : times)
-    t /= timeConstSecond;
-
-  parser.addSymbol("StageStatus", iinst);
-  parser.addSymbol("StageTime", times);
-  parser.addSymbol("StagePlace", places);
-  parser.addSymbol("StagePoints", points);
-
-  parser.addSymbol("InputStatus", runner.getInputStatus());
-  parser.addSymbol("InputTime", runner.getInputTime() / timeConstSecond);
-  parser.addSymbol("InputPlace", runner.getInputPlace());
-  parser.addSymbol("InputPoints", runner.getInputPoints());
-
-  parser.addSymbol("Fee", runner.getDCI().getInt("Fee"));
+  parser.addSymbol(symbolSlot[SFee], runner.getDCI().getInt("Fee"));
 
   const pClub pc = runner.getClubRef();
   if (pc) {
-    parser.addSymbol("ClubId", pc->getId());
-    parser.addSymbol("DistrictId", pc->getDCI().getInt("District"));
+    parser.addSymbol(symbolSlot[SClubId], pc->getId());
+    parser.addSymbol(symbolSlot[SDistrictId], pc->getDCI().getInt("District"));
   }
   else {
-    parser.addSymbol("ClubId", 0);
-    parser.addSymbol("DistrictId", 0);
+    parser.addSymbol(symbolSlot[SClubId], 0);
+    parser.addSymbol(symbolSlot[SDistrictId], 0);
   }
-  parser.addSymbol("Bib", _wtoi(runner.getBib().c_str()));
+  parser.addSymbol(symbolSlot[SBib], _wtoi(runner.getBib().c_str()));
 }
 
 void DynamicResult::prepareCalculations(oTeam &team, bool classResult) const {
@@ -1279,102 +1279,116 @@ void DynamicResult::prepareCalculations(oTeam &team, bool classResult) const {
       dataB[k] = r->getDCI().getInt("DataB");
     }
   }
-  parser.removeSymbol("CardControls");
-  parser.removeSymbol("CardPunches");
-  parser.removeSymbol("CardTimes");
-  parser.removeSymbol("Course");
-  parser.removeSymbol("CourseLength");
-  parser.removeSymbol("CourseId");
-  parser.removeSymbol("LegPlace");
-  parser.removeSymbol("LegTimeAfter");
-  parser.removeSymbol("LegTimeDeviation");
-  parser.removeSymbol("Leg");
-  parser.removeSymbol("SplitTimes");
-  parser.removeSymbol("SplitTimesAccumulated");
-  parser.removeSymbol("LegTimeDeviation");
-  parser.removeSymbol("BirthYear");
-  parser.removeSymbol("Age");
+  // Runner symbols without a value for a team
+  for (int g : {LSCard, LSCourse, LSLegTimeDeviation, LSLegTimeAfter, LSLegPlace}) {
+    for (int slot : deferredSlot[g])
+      parser.removeSymbol(slot);
+  }
+  parser.removeSymbol(symbolSlot[SLeg]);
+  parser.removeSymbol(symbolSlot[SBirthYear]);
+  parser.removeSymbol(symbolSlot[SAge]);
   
-  parser.addSymbol("RunnerOutputNumbers", runnerOutputNumbers);
-  parser.addSymbol("RunnerOutputTimes", runnerOutputTimes);
-
-  parser.addSymbol("RunnerStatus", status);
-  parser.addSymbol("RunnerTime", time);
-  parser.addSymbol("RunnerStart", start);
-  parser.addSymbol("RunnerFinish", finish);
-  parser.addSymbol("RunnerPoints", points);
-
-  parser.addSymbol("RunnerDataA", dataA);
-  parser.addSymbol("RunnerDataB", dataB);
+  parser.addSymbol(symbolSlot[SRunnerOutputNumbers], runnerOutputNumbers);
+  parser.addSymbol(symbolSlot[SRunnerOutputTimes], runnerOutputTimes);
 
-  parser.addSymbol("PatrolRogainingScore", team.getRogainingPatrolPoints(false));
-  parser.addSymbol("PatrolRogainingReduction", team.getRogainingPatrolReduction());
-  parser.addSymbol("PatrolRogainingOvertime", team.getRogainingPatrolOvertime());
+  parser.addSymbol(symbolSlot[SRunnerStatus], status);
+  parser.addSymbol(symbolSlot[SRunnerTime], time);
+  parser.addSymbol(symbolSlot[SRunnerStart], start);
+  parser.addSymbol(symbolSlot[SRunnerFinish], finish);
+  parser.addSymbol(symbolSlot[SRunnerPoints], points);
 
-  parser.addSymbol("RunnerCardPunches", team.getResultCache(oTeam::RCCCardPunches));
-  parser.addSymbol("RunnerCardTimes", team.getResultCache(oTeam::RCCCardTimes));
-  parser.addSymbol("RunnerCardControls", team.getResultCache(oTeam::RCCCardControls));
+  parser.addSymbol(symbolSlot[SRunnerDataA], dataA);
+  parser.addSymbol(symbolSlot[SRunnerDataB], dataB);
 
-  parser.addSymbol("RunnerCourse", team.getResultCache(oTeam::RCCCourse));
-  parser.addSymbol("RunnerSplitTimes", team.getResultCache(oTeam::RCCSplitTime));
+  parser.addSymbol(symbolSlot[SPatrolRogainingScore], team.getRogainingPatrolPoints(false));
+  parser.addSymbol(symbolSlot[SPatrolRogainingReduction], team.getRogainingPatrolReduction());
+  parser.addSymbol(symbolSlot[SPatrolRogainingOvertime], team.getRogainingPatrolOvertime());
 
-  pClass cls = team.getClassRef(true);
-  if (cls) {
-    int nl = max<int>(1, cls->getNumStages() - 1);
-    parser.addSymbol("ShortestClassTime", cls->getTotalLegLeaderTime(oClass::AllowRecompute::Yes, nl, false, false) / timeConstSecond);
-  }
+  lazyTeam = &team;
+  deferSymbols(true);
 }
 
 void DynamicResult::prepareCalculations(oRunner &runner, bool classResult) const {
   GeneralResult::prepareCalculations(runner, classResult);
   prepareCommon(runner, classResult);
-  pCard pc = runner.getCard();
-  if (pc) {
+  lazyRunner = &runner;
+  deferSymbols(false);
+
+  parser.addSymbol(symbolSlot[SLeg], runner.getLegNumber());
+  parser.addSymbol(symbolSlot[SBirthYear], runner.getBirthYear());
+  int ba = runner.getBirthAge();
+  parser.addSymbol(symbolSlot[SAge], ba);
+  parser.addSymbol(symbolSlot[SAgeLowLimit], lowAgeLimit);
+  parser.addSymbol(symbolSlot[SAgeHighLimit], highAgeLimit);
+
+  parser.addSymbol(symbolSlot[SCheckTime], runner.getCheckTime() / timeConstSecond);
+}
+
+namespace {
+  // Names of DynamicResult::PreparedSymbol
+  const char *preparedSymbols[] = {
+    "Status", "Start", "Finish", "Time", "Place", "Points",
+    "PointReduction", "PointOvertime", "PointGross", "PointAdjustment", "TimeAdjustment",
+    "TotalStatus", "TotalTime", "TotalPlace",
+    "InputStatus", "InputTime", "InputPlace", "InputPoints", "Shorten",
+    "DataA", "DataB", "ClassDataA", "ClassDataB", "Fee", "ClubId", "DistrictId", "Bib",
+    "Leg", "BirthYear", "Age", "AgeLowLimit", "AgeHighLimit", "CheckTime",
+    "ComputedTime", "ComputedStatus", "ComputedPoints",
+    "RunnerOutputNumbers", "RunnerOutputTimes",
+    "RunnerStatus", "RunnerTime", "RunnerStart", "RunnerFinish", "RunnerPoints",
+    "RunnerDataA", "RunnerDataB",
+    "PatrolRogainingScore", "PatrolRogainingReduction", "PatrolRogainingOvertime",
+  };
+
+  // Symbols in each group of DynamicResult::LazySymbol
+  const vector<const char *> runnerLazySymbols[] = {
+    {"StageStatus", "StageTime", "StagePlace", "StagePoints"},
+    {"CardPunches", "CardTimes", "CardControls"},
+    {"Course", "CourseLength", "CourseId", "SplitTimes", "SplitTimesAccumulated"},
+    {"LegTimeDeviation"},
+    {"LegTimeAfter"},
+    {"LegPlace"},
+    {"ShortestClassTime"},
+  };
+
+  const vector<const char *> teamLazySymbols[] = {
+    {"StageStatus", "StageTime", "StagePlace", "StagePoints"},
+    {"RunnerCardPunches", "RunnerCardTimes", "RunnerCardControls"},
+    {"RunnerCourse", "RunnerSplitTimes"},
+    {},
+    {},
+    {},
+    {"ShortestClassTime"},
+  };
+
+  void getCardSymbols(const oRunner &runner, vector<int> &codes, vector<int> &times, vector<int> &controls) {
+    codes.clear();
+    times.clear();
+    controls.clear();
+    pCard pc = runner.getCard();
+    if (!pc)
+      return;
+
     vector<pPunch> punches;
     pc->getPunches(punches);
-    int np = 0;
-    for (size_t k = 0; k < punches.size(); k++) {
-      if (punches[k]->getTypeCode() >= 30)
-        np++;
-    }
-    vector<int> times(np);
-    vector<int> codes(np);
-    vector<int> controls(np);
-    int ip = 0;
     for (size_t k = 0; k < punches.size(); k++) {
       if (punches[k]->getTypeCode() >= 30) {
-        times[ip] = punches[k]->getAdjustedTime() / timeConstSecond;
-        codes[ip] = punches[k]->getTypeCode();
-        controls[ip] = punches[k]->isUsedInCourse() ? punches[k]->getControlId() : -1;
-        ip++;
+        times.push_back(punches[k]->getAdjustedTime() / timeConstSecond);
+        codes.push_back(punches[k]->getTypeCode());
+        controls.push_back(punches[k]->isUsedInCourse() ? punches[k]->getControlId() : -1);
       }
     }
-    parser.addSymbol("CardPunches", codes);
-    parser.addSymbol("CardTimes", times);
-    parser.addSymbol("CardControls", controls);
-
-    pTeam t = runner.getTeam();
-    if (t) {
-      int leg = runner.getLegNumber();
-      t->setResultCache(oTeam::RCCCardTimes, leg, times);
-      t->setResultCache(oTeam::RCCCardPunches, leg, codes);
-      t->setResultCache(oTeam::RCCCardControls, leg, controls);
-    }
-  }
-  else {
-    vector<int> e;
-    parser.addSymbol("CardPunches", e);
-    parser.addSymbol("CardTimes", e);
-    parser.addSymbol("CardControls", e);
   }
 
-  pCourse crs = runner.getCourse(true);
-  const vector<SplitData> &sp = runner.getSplitTimes(false);
+  pCourse getCourseSymbols(oRunner &runner, vector<int> &eCrs, vector<int> &eSplitTime, vector<int> &eAccTime) {
+    eCrs.clear();
+    eSplitTime.clear();
+    eAccTime.clear();
+    pCourse crs = runner.getCourse(true);
+    if (!crs)
+      return nullptr;
 
-  if (crs) {
-    vector<int> eCrs;
-    vector<int> eSplitTime;
-    vector<int> eAccTime;
+    const vector<SplitData> &sp = runner.getSplitTimes(false);
     eCrs.reserve(crs->getNumControls());
     eSplitTime.reserve(crs->getNumControls());
     eAccTime.reserve(crs->getNumControls());
@@ -1409,51 +1423,257 @@ void DynamicResult::prepareCalculations(oRunner &runner, bool classResult) const
       eAccTime.push_back(0);
       eSplitTime.push_back(-1);
     }
-
-    parser.addSymbol("CourseLength", crs->getLength());
-    parser.addSymbol("CourseId", crs->getId());
-    parser.addSymbol("Course", eCrs);
-    parser.addSymbol("SplitTimes", eSplitTime);
-    parser.addSymbol("SplitTimesAccumulated", eAccTime);
-    pTeam t = runner.getTeam();
-    if (t) {
-      int leg = runner.getLegNumber();
-      t->setResultCache(oTeam::RCCCourse, leg, eCrs);
-      t->setResultCache(oTeam::RCCSplitTime, leg, eSplitTime);
+    return crs;
+  }
+}
+
+void DynamicResult::deferSymbols(bool team) const {
+  for (int g = 0; g < LSLast; g++) {
+    int key = team ? LSLast + g : g;
+    for (int slot : deferredSlot[key])
+      parser.deferSymbol(slot, key);
+  }
+}
+
+void DynamicResult::resolveSymbolSlots() const {
+  static_assert(sizeof(preparedSymbols) / sizeof(preparedSymbols[0]) == SLast, "Missing symbol name");
+  if (!symbolSlot.empty())
+    return; // Slots are never removed from the parser
+
+  symbolSlot.resize(SLast);
+  for (int k = 0; k < SLast; k++)
+    symbolSlot[k] = parser.getSymbolSlot(preparedSymbols[k]);
+
+  deferredSlot.resize(2 * LSLast);
+  for (int key = 0; key < 2 * LSLast; key++) {
+    const vector<const char *> &names = key < LSLast ? runnerLazySymbols[key] : teamLazySymbols[key - LSLast];
+    for (const char *name : names)
+      deferredSlot[key].push_back(parser.getSymbolSlot(name));
+  }
+}
+
+void DynamicResult::computeDeferred(int key) const {
+  auto t0 = chrono::steady_clock::now();
+  const bool team = key >= LSLast;
+  const LazySymbol group = LazySymbol(team ? key - LSLast : key);
+  oAbstractRunner *ar = team ? (oAbstractRunner *)lazyTeam : (oAbstractRunner *)lazyRunner;
+  if (ar == nullptr)
+    throw meosException("Internal error");
+
+  switch (group) {
+  case LSStage: {
+    vector<RunnerStatus> inst;
+    vector<int> times;
+    vector<int> points;
+    vector<int> places;
+    vector<int> iinst;
+    ar->getInputResults(inst, times, points, places);
+    for (RunnerStatus s : inst)
+      iinst.push_back(s);
+
+    for (int &t : times)
+      t /= timeConstSecond;
+
+    parser.addSymbol("StageStatus", iinst);
+    parser.addSymbol("StageTime", times);
+    parser.addSymbol("StagePlace", places);
+    parser.addSymbol("StagePoints", points);
+    break;
+  }
+  case LSCard:
+    if (team) {
+      int nr = lazyTeam->getNumRunners();
+      vector< vector<int> > codes(nr), times(nr), controls(nr);
+      for (int k = 0; k < nr; k++) {
+        pRunner r = lazyTeam->getRunner(k);
+        if (r)
+          getCardSymbols(*r, codes[k], times[k], controls[k]);
+      }
+      parser.addSymbol("RunnerCardPunches", codes);
+      parser.addSymbol("RunnerCardTimes", times);
+      parser.addSymbol("RunnerCardControls", controls);
+    }
+    else {
+      vector<int> codes, times, controls;
+      getCardSymbols(*lazyRunner, codes, times, controls);
+      parser.addSymbol("CardPunches", codes);
+      parser.addSymbol("CardTimes", times);
+      parser.addSymbol("CardControls", controls);
+    }
+    break;
+  case LSCourse:
+    if (team) {
+      int nr = lazyTeam->getNumRunners();
+      vector< vector<int> > course(nr), splitTime(nr);
+      vector<int> accTime;
+      for (int k = 0; k < nr; k++) {
+        pRunner r = lazyTeam->getRunner(k);
+        if (r)
+          getCourseSymbols(*r, course[k], splitTime[k], accTime);
+      }
+      parser.addSymbol("RunnerCourse", course);
+      parser.addSymbol("RunnerSplitTimes", splitTime);
+    }
+    else {
+      vector<int> course, splitTime, accTime;
+      pCourse crs = getCourseSymbols(*lazyRunner, course, splitTime, accTime);
+      parser.addSymbol("CourseLength", crs ? crs->getLength() : -1);
+      parser.addSymbol("CourseId", crs ? crs->getId() : 0);
+      parser.addSymbol("Course", course);
+      parser.addSymbol("SplitTimes", splitTime);
+      parser.addSymbol("SplitTimesAccumulated", accTime);
+    }
+    break;
+  case LSLegTimeDeviation: {
+    vector<int> delta;
+    lazyRunner->getSplitAnalysis(delta);
+    parser.addSymbol("LegTimeDeviation", delta);
+    break;
+  }
+  case LSLegTimeAfter: {
+    vector<int> after;
+    lazyRunner->getLegTimeAfter(after);
+    parser.addSymbol("LegTimeAfter", after);
+    break;
+  }
+  case LSLegPlace: {
+    vector<int> place;
+    lazyRunner->getLegPlaces(place);
+    parser.addSymbol("LegPlace", place);
+    break;
+  }
+  case LSShortestClassTime: {
+    int shortest = 0;
+    pClass cls = ar->getClassRef(true);
+    if (cls && team) {
+      int nl = max<int>(1, cls->getNumStages() - 1);
+      shortest = cls->getTotalLegLeaderTime(oClass::AllowRecompute::Yes, nl, false, false) / timeConstSecond;
+    }
+    else if (cls) {
+      shortest = cls->getBestLegTime(oClass::AllowRecompute::Yes, lazyRunner->getLegNumber(), false) / timeConstSecond;
+    }
+    parser.addSymbol("ShortestClassTime", shortest);
+    break;
+  }
+  default:
+    throw meosException("Internal error");
+  }
+
+  if (symbolCost.size() <= size_t(key))
+    symbolCost.resize(2 * LSLast);
+  SymbolCost &cost = symbolCost[key];
+  if (cost.symbols.empty()) {
+    const vector<const char *> &names = (team ? teamLazySymbols : runnerLazySymbols)[group];
+    for (const char *s : names) {
+      if (!cost.symbols.empty())
+        cost.symbols += ", ";
+      cost.symbols += s;
+    }
+  }
+  cost.count++;
+  cost.microseconds += chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - t0).count();
+}
+
+void DynamicResult::calculateRunners(const vector<pRunner> &runners, bool classResult, vector<pair<int, int>> &scores) const {
+  const int n = runners.size();
+  vector<int> status(n), start(n), finish(n), time(n), points(n);
+  vector<int> computedStatus(n), computedTime(n), computedPoints(n);
+
+  vector<Parser::Column> columns = {
+    {"Status", status.data()},
+    {"Start", start.data()},
+    {"Finish", finish.data()},
+    {"Time", time.data()},
+    {"Points", points.data()},
+  };
+  for (const char *c : {"StatusUnknown", "StatusOK", "StatusMP", "StatusDNF", "StatusCANCEL", "StatusDNS",
+                        "StatusMAX", "StatusDQ", "StatusOutOfCompetition", "StatusNoTiming",
+                        "StatusNotCompetiting", "StatusNotCompeting", "LocalTime", "MaxTime", "InputNumber"})
+    columns.push_back({c, nullptr});
+
+  vector<Parser::Column> scoreColumns = columns;
+  scoreColumns.push_back({"ComputedStatus", computedStatus.data()});
+  scoreColumns.push_back({"ComputedTime", computedTime.data()});
+  scoreColumns.push_back({"ComputedPoints", computedPoints.data()});
+
+  // Evaluate over columns if all runner methods are single expressions of the columns
+  for (DynamicMethods m : {MDeduceRTime, MDeduceRStatus, MDeduceRPoints, MRScore}) {
+    if (methods[m].source.empty())
+      continue;
+    if (!getMethod(m) || !parser.isColumnProgram(methods[m].program, m == MRScore ? scoreColumns : columns)) {
+      GeneralResult::calculateRunners(runners, classResult, scores);
+      return;
     }
   }
+
+  bool useComputed = classResult == false;
+  for (int k = 0; k < n; k++) {
+    oRunner &r = *runners[k];
+    GeneralResult::prepareCalculations(r, classResult);
+    status[k] = r.getStatus();
+    finish[k] = r.getFinishTime();
+    if (status[k] == StatusUnknown && finish[k] > 0)
+      status[k] = StatusOK;
+    finish[k] /= timeConstSecond;
+    start[k] = r.getStartTime() / timeConstSecond;
+    time[k] = r.getRunningTime(useComputed) / timeConstSecond;
+    points[k] = r.getRogainingPoints(useComputed, false);
+  }
+
+  vector<int> result(n);
+  if (getMethod(MDeduceRTime)) {
+    parser.executeColumns(methods[MDeduceRTime].program, columns, n, result.data());
+    for (int k = 0; k < n; k++)
+      runners[k]->tmpResult.runningTime = result[k] * timeConstSecond + runners[k]->getSubSeconds();
+  }
   else {
-    vector<int> e;
-    parser.addSymbol("CourseLength", -1);
-    parser.addSymbol("CourseId", 0);
-    parser.addSymbol("Course", e);
-    parser.addSymbol("SplitTimes", e);
-    parser.addSymbol("SplitTimesAccumulated", e);
+    for (pRunner r : runners)
+      r->tmpResult.runningTime = GeneralResult::deduceTime(*r, r->tmpResult.startTime);
   }
 
-  pClass cls = runner.getClassRef(true);
-  if (cls) {
-    int nl = runner.getLegNumber();
-    parser.addSymbol("ShortestClassTime", cls->getBestLegTime(oClass::AllowRecompute::Yes, nl, false) / timeConstSecond);
-  }
-  vector<int> delta;
-  vector<int> place;
-  vector<int> after;
-  runner.getSplitAnalysis(delta);
-  runner.getLegTimeAfter(after);
-  runner.getLegPlaces(place);
-
-  parser.addSymbol("LegTimeDeviation", delta);
-  parser.addSymbol("LegTimeAfter", after);
-  parser.addSymbol("LegPlace", place);
-  parser.addSymbol("Leg", runner.getLegNumber());
-  parser.addSymbol("BirthYear", runner.getBirthYear());
-  int ba = runner.getBirthAge();
-  parser.addSymbol("Age", ba);
-  parser.addSymbol("AgeLowLimit", lowAgeLimit);
-  parser.addSymbol("AgeHighLimit", highAgeLimit);
+  if (getMethod(MDeduceRStatus)) {
+    parser.executeColumns(methods[MDeduceRStatus].program, columns, n, result.data());
+    for (int k = 0; k < n; k++)
+      runners[k]->tmpResult.status = toStatus(result[k]);
+  }
+  else {
+    for (pRunner r : runners)
+      r->tmpResult.status = GeneralResult::deduceStatus(*r);
+  }
 
-  parser.addSymbol("CheckTime", runner.getCheckTime() / timeConstSecond);
+  if (getMethod(MDeduceRPoints)) {
+    parser.executeColumns(methods[MDeduceRPoints].program, columns, n, result.data());
+    for (int k = 0; k < n; k++)
+      runners[k]->tmpResult.points = result[k];
+  }
+  else {
+    for (pRunner r : runners)
+      r->tmpResult.points = GeneralResult::deducePoints(*r);
+  }
+
+  scores.resize(n);
+  if (getMethod(MRScore)) {
+    for (int k = 0; k < n; k++) {
+      const oAbstractRunner::TempResult &res = runners[k]->tmpResult;
+      computedStatus[k] = res.status;
+      computedTime[k] = res.runningTime / timeConstSecond;
+      computedPoints[k] = res.points;
+    }
+    parser.executeColumns(methods[MRScore].program, scoreColumns, n, result.data());
+    for (int k = 0; k < n; k++)
+      scores[k] = make_pair(0, result[k]);
+  }
+  else {
+    for (int k = 0; k < n; k++) {
+      oRunner &r = *runners[k];
+      scores[k] = GeneralResult::score(r, r.tmpResult.status, r.tmpResult.runningTime, r.tmpResult.points, false);
+    }
+  }
+
+  for (pRunner r : runners) {
+    r->tmpResult.outputTimes.clear();
+    r->tmpResult.outputNumbers.clear();
+  }
 }
 
 void DynamicResult::storeOutput(vector<int> &times, vector<int> &numbers) const {
@@ -1498,9 +1718,19 @@ void DynamicResult::debugDumpVariables(gdioutput &gdi, bool includeSymbols) cons
   int c1 = gdi.getCX();
   int c2 = c1 + gdi.scaleLength(170);
   if (includeSymbols) {
+    // Costs first, since listing the symbols computes all of them
+    vector<SymbolCost> cost = symbolCost;
     gdi.addString("", 1, "Symboler");
     parser.dumpSymbols(gdi, c1, c2);
     gdi.dropLine();
+
+    for (const SymbolCost &sc : cost) {
+      if (sc.count == 0)
+        continue;
+      int cy = gdi.getCY();
+      gdi.addStringUT(cy, c1, monoText, sc.symbols, c2 - c1 - 10);
+      gdi.addStringUT(cy, c2, monoText, itos(sc.count) + " x, " + itos(sc.microseconds) + " us");
+    }
   }
   else {
     gdi.addString("", 1, "Variabler");
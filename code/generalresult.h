@@ -58,6 +58,9 @@ protected:
   virtual void prepareCalculations(oRunner &runner, bool classResult) const;
   virtual void storeOutput(vector<int> &times, vector<int> &numbers) const;
 
+  /** Calculate the temporary results and scores of the runners, one runner at a time.*/
+  virtual void calculateRunners(const vector<pRunner> &runners, bool classResult, vector<pair<int, int>> &scores) const;
+
   int getListParamTimeToControl() const;
   int getListParamTimeFromControl() const;
 
@@ -95,12 +98,7 @@ public:
       if (place != o.place)
         return place < o.place;
 
-      const wstring &name = src->getName();
-      const wstring &oname = o.src->getName();
-
-      return CompareString(LOCALE_USER_DEFAULT, 0,
-        name.c_str(), name.length(),
-        oname.c_str(), oname.length()) == CSTR_LESS_THAN;
+      return src->getNameKey() < o.src->getNameKey();
     }
 
     bool operator<(const GeneralResultInfo &o) const {
@@ -193,6 +191,13 @@ protected:
 class DynamicResult : public GeneralResult {
 public:
 
+  /** Accumulated time spent computing a group of symbols on demand.*/
+  struct SymbolCost {
+    string symbols;
+    int count = 0;
+    int64_t microseconds = 0;
+  };
+
   enum DynamicMethods {
     MTScore,
     MDeduceTStatus,
@@ -215,9 +220,54 @@ private:
   mutable int lowAgeLimit = -1;
   mutable int highAgeLimit = 1000;
 
+  // Groups of symbols that are expensive to compute. They are bound first when a method reads them.
+  enum LazySymbol {
+    LSStage,
+    LSCard,
+    LSCourse,
+    LSLegTimeDeviation,
+    LSLegTimeAfter,
+    LSLegPlace,
+    LSShortestClassTime,
+    LSLast
+  };
+
+  // Runner and team that deferred symbols refer to
+  mutable oRunner *lazyRunner = nullptr;
+  mutable oTeam *lazyTeam = nullptr;
+  mutable vector<SymbolCost> symbolCost;
+
+  void deferSymbols(bool team) const;
+  void computeDeferred(int key) const;
+
+  // Symbols set for each runner or team
+  enum PreparedSymbol {
+    SStatus, SStart, SFinish, STime, SPlace, SPoints,
+    SPointReduction, SPointOvertime, SPointGross, SPointAdjustment, STimeAdjustment,
+    STotalStatus, STotalTime, STotalPlace,
+    SInputStatus, SInputTime, SInputPlace, SInputPoints, SShorten,
+    SDataA, SDataB, SClassDataA, SClassDataB, SFee, SClubId, SDistrictId, SBib,
+    SLeg, SBirthYear, SAge, SAgeLowLimit, SAgeHighLimit, SCheckTime,
+    SComputedTime, SComputedStatus, SComputedPoints,
+    SRunnerOutputNumbers, SRunnerOutputTimes,
+    SRunnerStatus, SRunnerTime, SRunnerStart, SRunnerFinish, SRunnerPoints,
+    SRunnerDataA, SRunnerDataB,
+    SPatrolRogainingScore, SPatrolRogainingReduction, SPatrolRogainingOvertime,
+    SLast
+  };
+
+  // Parser slots of the prepared symbols and of the deferred symbols by key,
+  // resolved once in declareSymbols.
+  mutable vector<int> symbolSlot;
+  mutable vector<vector<int>> deferredSlot;
+  void resolveSymbolSlots() const;
+
+  void calculateRunners(const vector<pRunner> &runners, bool classResult, vector<pair<int, int>> &scores) const override;
+
   class MethodInfo {
     string source;
     mutable ParseNode *pn;
+    mutable ParseProgram program;
     string description;
   public:
     friend class DynamicResult;
@@ -239,6 +289,8 @@ private:
 
 
   const ParseNode *getMethod(DynamicMethods method) const;
+  /** Run the compiled method. The method must exist.*/
+  int runMethod(DynamicMethods method) const;
   void addSymbol(DynamicMethods method, const char *symb, const char *name);
   RunnerStatus toStatus(int status) const;
   
@@ -325,6 +377,9 @@ public:
   void compile(bool forceRecompile) const;
 
   void debugDumpVariables(gdioutput &gdi, bool includeSymbols) const;
+
+  /** Cost of computing symbols on demand since the last preparation, indexed by symbol group.*/
+  const vector<SymbolCost> &getSymbolCost() const {return symbolCost;}
    
   void clear();
 };
@@ -22,6 +22,8 @@
 ************************************************************************/
 
 
+/** Hash map from integer keys to values. Open addressing with linear probing
+    and Robin Hood displacement, stored in a single flat array.*/
 template<class T, class KEY = int> class intkeymap {
 private:
   const static KEY NoKey = -1013;
@@ -30,26 +32,30 @@ private:
     KEY key;
     T value;
   };
-  T dummy;
-  T tmp;
+  T noValue;
   keypair *keys;
-  unsigned siz;
+  unsigned siz; // Number of slots, a power of two
   unsigned used;
-  intkeymap *next;
-  intkeymap *parent;
-  double allocFactor;
-  T noValue;
-  unsigned hash1;
-  unsigned hash2;
-  int level;
-  static int optsize(int arg);
+  unsigned shift;
+
+  static unsigned optsize(int arg);
+  void allocate(unsigned size);
+
+  unsigned home(KEY key) const {
+    return unsigned((uint64_t(key) * 0x9E3779B97F4A7C15ull) >> shift);
+  }
+
+  unsigned distance(unsigned slot) const {
+    return (slot - home(keys[slot].key)) & (siz - 1);
+  }
 
-  T &rehash(int size, KEY key, const T &value);
+  int findSlot(KEY key) const;
+  T &emplace(KEY key, const T &value);
+  void rehash(unsigned size);
   T &get(const KEY key);
 
-  void *lookup(KEY key) const;
 public:
-  virtual ~intkeymap();
+  ~intkeymap();
   intkeymap(int size);
   intkeymap();
   intkeymap(const intkeymap &co);
@@ -61,16 +67,29 @@ public:
   void clear();
 
   void resize(int size);
-  int count(KEY key) {
-    return lookup(key, dummy) ? 1:0;
+  int count(KEY key) const {
+    return findSlot(key) >= 0 ? 1:0;
   }
   bool lookup(KEY key, T &value) const;
 
+  /** Return a pointer to the value of key, or nullptr.*/
+  T *find(KEY key) {
+    int slot = findSlot(key);
+    return slot >= 0 ? &keys[slot].value : nullptr;
+  }
+
+  const T *find(KEY key) const {
+    int slot = findSlot(key);
+    return slot >= 0 ? &keys[slot].value : nullptr;
+  }
+
   void insert(KEY key, const T &value);
   void remove(KEY key);
   void erase(KEY key) {remove(key);}
-  const T operator[](KEY key) const
-    {if (lookup(key,tmp)) return tmp; else return T();}
+  const T operator[](KEY key) const {
+    const T *v = find(key);
+    return v ? *v : T();
+  }
 
   T &operator[](KEY key) {
     return get(key);
@@ -28,94 +28,59 @@
 
 
 
-template <class T, class KEY> intkeymap<T, KEY>::intkeymap()  {
-  siz = 17;
-  allocFactor = 1.5;
+template <class T, class KEY> void intkeymap<T, KEY>::allocate(unsigned size) {
+  siz = size;
+  shift = 64;
+  while (size > 1) {
+    size >>= 1;
+    shift--;
+  }
   keys = new keypair[siz];
-  hash1 = siz / 2 + 3;
-  hash2 = siz / 3 + 2;
+  for (unsigned k = 0; k < siz; k++)
+    keys[k].key = NoKey;
   used = 0;
-  next = 0;
-  level = 0;
-  parent = 0;
-  dummy = 0;
-  noValue = 0;
-  clear();
 }
 
-template <class T, class KEY> intkeymap<T, KEY>::intkeymap(int _size)
+template <class T, class KEY> intkeymap<T, KEY>::intkeymap() : noValue()  {
+  allocate(16);
+}
+
+template <class T, class KEY> intkeymap<T, KEY>::intkeymap(int _size) : noValue()
 {
-  allocFactor = 1.3;
-  siz = optsize(_size);
-  keys = new keypair[siz];
-  hash1 = siz / 2 + 3;
-  hash2 = siz / 3 + 2;
-  used = 0;
-  next = 0;
-  level = 0;
-  parent = 0;
-  dummy = T();
-  noValue = T();
-  clear();
+  allocate(optsize(_size));
 }
 
 template <class T, class KEY> intkeymap<T, KEY>::intkeymap(const intkeymap &co)
 {
-  allocFactor =  co.allocFactor;
+  noValue = co.noValue;
   siz = co.siz;
-  keys = new keypair[siz];
-  hash1 = co.hash1;
-  hash2 = co.hash2;
+  shift = co.shift;
   used = co.used;
-  level = co.level;
-  dummy = co.dummy;
-  noValue = co.noValue;
-
+  keys = new keypair[siz];
   for (unsigned k=0; k<siz; k++)
     keys[k] = co.keys[k];
-
-  parent = 0;
-  next = 0;
-
-  if (co.next) {
-    next = new intkeymap<T, KEY>(*co.next);
-    next->parent = this;
-  }
 }
 
 template <class T, class KEY>
 const intkeymap<T, KEY> &intkeymap<T, KEY>::operator=(const intkeymap<T, KEY> &co) {
-  clear();
-  delete[] keys;
+  if (this == &co)
+    return *this;
 
-  allocFactor = co.allocFactor;
+  delete[] keys;
+  noValue = co.noValue;
   siz = co.siz;
-  keys = new keypair[siz];
-  hash1 = co.hash1;
-  hash2 = co.hash2;
+  shift = co.shift;
   used = co.used;
-  level = co.level;
-  dummy = co.dummy;
-  noValue = co.noValue;
-
+  keys = new keypair[siz];
   for (unsigned k = 0; k<siz; k++)
     keys[k] = co.keys[k];
 
-  parent = 0;
-  next = 0;
-
-  if (co.next) {
-    next = new intkeymap<T, KEY>(*co.next);
-    next->parent = this;
-  }
   return *this;
 }
 
 template <class T, class KEY> intkeymap<T, KEY>::~intkeymap()
 {
   delete[] keys;
-  if (next)
-    delete next;
 }
 
 template <class T, class KEY> void intkeymap<T, KEY>::clear()
@@ -124,206 +89,121 @@ template <class T, class KEY> void intkeymap<T, KEY>::clear()
     keys[k].key = NoKey;
 
   used = 0;
-  delete next;
-  next = 0;
 }
 
-template <class T, class KEY> void intkeymap<T, KEY>::insert(KEY key, const T &value)
+template <class T, class KEY> int intkeymap<T, KEY>::findSlot(KEY key) const
 {
-  if (key == NoKey) {
-    noValue = value;
-    return;
-  }
-
-  keypair *ptr = (keypair *)lookup(key);
-  if (ptr) {
-    ptr->key = key;
-    ptr->value = value;
-    return;
-  }
-
-  unsigned hk = unsigned(key) % siz;
-
-  if (keys[hk].key == NoKey)
-    used++;
-  if (keys[hk].key == NoKey || keys[hk].key == key) {
-    keys[hk].key = key;
-    keys[hk].value = value;
-    return;
-  }
-
-  hk = unsigned(key + hash1) % siz;
+  if (key == NoKey)
+    return -1;
 
-  if (keys[hk].key == NoKey)
-    used++;
-  if (keys[hk].key == NoKey || keys[hk].key == key) {
-    keys[hk].key = key;
-    keys[hk].value = value;
-    return;
+  const unsigned mask = siz - 1;
+  unsigned slot = home(key);
+  for (unsigned dist = 0; ; dist++) {
+    const KEY k = keys[slot].key;
+    if (k == key)
+      return slot;
+    // An element closer to its home slot than dist means key is not present
+    if (k == NoKey || distance(slot) < dist)
+      return -1;
+    slot = (slot + 1) & mask;
   }
+}
 
-  hk = unsigned(key + hash2) % siz;
+template <class T, class KEY> T &intkeymap<T, KEY>::emplace(KEY key, const T &value)
+{
+  // Keep load below 7/8
+  if ((used + 1) * 8 > siz * 7)
+    rehash(siz * 2);
+
+  const unsigned mask = siz - 1;
+  keypair item = {key, value};
+  unsigned slot = home(key);
+  unsigned dist = 0;
+  int placed = -1;
+  while (true) {
+    if (keys[slot].key == NoKey) {
+      keys[slot] = std::move(item);
+      used++;
+      return keys[placed >= 0 ? placed : slot].value;
+    }
 
-  if (keys[hk].key == NoKey)
-    used++;
-  if (keys[hk].key == NoKey || keys[hk].key == key) {
-    keys[hk].key = key;
-    keys[hk].value = value;
-    return;
+    // Take the slot from an element that is closer to its home
+    unsigned existingDist = distance(slot);
+    if (existingDist < dist) {
+      std::swap(item, keys[slot]);
+      if (placed < 0)
+        placed = slot;
+      dist = existingDist;
+    }
+    slot = (slot + 1) & mask;
+    dist++;
   }
+}
 
-  if (next) {
-    next->insert(key, value);
-    return;
-  }
-  else if (level < 3) {
-    next = new intkeymap<T, KEY>(siz/2);
-    next->level = level + 1;
-    next->parent = this;
-    next->insert(key, value);
+template <class T, class KEY> void intkeymap<T, KEY>::insert(KEY key, const T &value)
+{
+  if (key == NoKey) {
+    noValue = value;
     return;
   }
 
-  rehash(0, key, value);
+  int slot = findSlot(key);
+  if (slot >= 0)
+    keys[slot].value = value;
+  else
+    emplace(key, value);
 }
 
 template <class T, class KEY> T &intkeymap<T, KEY>::get(KEY key)
 {
-  keypair *ptr = (keypair *)lookup(key);
-  if (ptr)
-    return ptr->value;
-
   if (key == NoKey)
     return noValue;
 
-  unsigned hk = unsigned(key) % siz;
+  int slot = findSlot(key);
+  if (slot >= 0)
+    return keys[slot].value;
 
-  if (keys[hk].key == NoKey) {
-    used++;
-    keys[hk].value = T();
-  }
-  if (keys[hk].key == NoKey || keys[hk].key == key) {
-    keys[hk].key = key;
-    return keys[hk].value;
-  }
-
-  hk = unsigned(key + hash1) % siz;
-
-  if (keys[hk].key == NoKey) {
-    used++;
-    keys[hk].value = T();
-  }
-  if (keys[hk].key == NoKey || keys[hk].key == key) {
-    keys[hk].key = key;
-    return keys[hk].value;
-  }
-
-  hk = unsigned(key + hash2) % siz;
-
-  if (keys[hk].key == NoKey) {
-    keys[hk].value = T();
-    used++;
-  }
-  if (keys[hk].key == NoKey || keys[hk].key == key) {
-    keys[hk].key = key;
-    return keys[hk].value;
-  }
-
-  if (next) {
-    return next->get(key);
-  }
-  else if (level < 3) {
-    next = new intkeymap<T, KEY>(siz/2);
-    next->level = level + 1;
-    next->parent = this;
-    return next->get(key);
-  }
-
-  return rehash(0, key, T());
+  return emplace(key, T());
 }
 
-
 template <class T, class KEY> void intkeymap<T, KEY>::remove(KEY key)
 {
-  unsigned hk = unsigned(key) % siz;
-  if (keys[hk].key == key) {
-    keys[hk].key = NoKey;
-    used--;
-    return;
-  }
-
-  hk = unsigned(key + hash1) % siz;
-  if (keys[hk].key == key) {
-    keys[hk].key = NoKey;
-    used--;
-    return;
-  }
-
-  hk = unsigned(key + hash2) % siz;
-  if (keys[hk].key == key) {
-    keys[hk].key = NoKey;
-    used--;
+  int slot = findSlot(key);
+  if (slot < 0)
     return;
-  }
 
-  if (next) {
-    next->remove(key);
-    return;
+  // Shift following elements back towards their home slots
+  const unsigned mask = siz - 1;
+  unsigned hole = slot;
+  unsigned next = (hole + 1) & mask;
+  while (keys[next].key != NoKey && distance(next) > 0) {
+    keys[hole] = std::move(keys[next]);
+    hole = next;
+    next = (next + 1) & mask;
   }
+  keys[hole].key = NoKey;
+  keys[hole].value = T();
+  used--;
 }
 
-template <class T, class KEY> T &intkeymap<T, KEY>::rehash(int _siz, KEY key, const T &value)
+template <class T, class KEY> void intkeymap<T, KEY>::rehash(unsigned size)
 {
-  if (parent)
-    return parent->rehash(_siz+used, key, value);
-  else {
-    intkeymap<T, KEY> nm(int((_siz+used)*allocFactor));
-    if (key != NoKey)
-      nm.insert(key, value);
-
-    intkeymap<T, KEY> *tmap = this;
-    while (tmap) {
-      int tsize = tmap->siz;
-      keypair *tkeys = tmap->keys;
-      for (int k=0; k<tsize; k++) {
-        if (tkeys[k].key != NoKey)
-          nm.insert(tkeys[k].key, tkeys[k].value);
-      }
-      tmap = tmap->next;
-    }
+  keypair *oldKeys = keys;
+  unsigned oldSiz = siz;
+  allocate(size);
 
-    // Swap
-    keypair *oldkeys = keys;
-
-    //Take next
-    delete next;
-    next = nm.next;
-    nm.next = 0;
-    if (next)
-      next->parent = this;
-
-    //Take keys
-    keys = nm.keys;
-    nm.keys = 0;
-    delete[] oldkeys;
-
-    // Copy relevant data
-    siz = nm.siz;
-    used = nm.used;
-    hash1 = nm.hash1;
-    hash2 = nm.hash2;
-
-    if (key!=NoKey)
-      return get(key);
-    return dummy;
+  for (unsigned k = 0; k < oldSiz; k++) {
+    if (oldKeys[k].key != NoKey)
+      emplace(oldKeys[k].key, oldKeys[k].value);
   }
+  delete[] oldKeys;
 }
 
 template <class T, class KEY> bool intkeymap<T, KEY>::lookup(KEY key, T &value) const
 {
-  keypair *ptr = (keypair *)lookup(key);
-  if (ptr) {
-    value = ptr->value;
+  int slot = findSlot(key);
+  if (slot >= 0) {
+    value = keys[slot].value;
     return true;
   }
   else {
@@ -332,72 +212,27 @@ template <class T, class KEY> bool intkeymap<T, KEY>::lookup(KEY key, T &value)
   }
 }
 
-template <class T, class KEY> void *intkeymap<T, KEY>::lookup(KEY key) const
-{
-  if (key == NoKey) {
-    return 0;
-  }
-
-  unsigned hk = unsigned(key) % siz;
-  if (keys[hk].key == key) {
-    return (void *)&keys[hk];
-  }
-
-  hk = unsigned(key + hash1) % siz;
-  if (keys[hk].key == key) {
-    return (void *)&keys[hk];
-  }
-
-  hk = unsigned(key + hash2) % siz;
-  if (keys[hk].key == key) {
-    return (void *)&keys[hk];
-  }
-
-  if (next)
-    return next->lookup(key);
-  else
-    return 0;
-}
-
-template <class T, class KEY> int intkeymap<T, KEY>::optsize(int a) {
-  if (a<5)
-    a = 5;
-
-  if ((a&1) == 0)
-    a++;
-
-  while (true)  {
-    if (a%3 == 0)
-      a+=2;
-    else if (a%5 == 0)
-      a+=2;
-    else if (a%7 == 0)
-      a+=2;
-    else if (a%11 == 0)
-      a+=2;
-    else if (a%13 == 0)
-      a+=2;
-    else
-      return a;
-  }
+template <class T, class KEY> unsigned intkeymap<T, KEY>::optsize(int a) {
+  // Smallest power of two keeping the load below 7/8
+  unsigned s = 8;
+  while (s * 7 < unsigned(max(a, 0)) * 8)
+    s *= 2;
+  return s;
 }
 
 template <class T, class KEY> int intkeymap<T, KEY>::size() const
 {
-  if (next)
-    return used + next->size();
-  else
-    return used;
+  return used;
 }
 
 template <class T, class KEY> bool intkeymap<T, KEY>::empty() const
 {
-  return used==0 && (next==0 || next->empty());
+  return used==0;
 }
 
 template <class T, class KEY> void intkeymap<T, KEY>::resize(int size)
 {
-  allocFactor = 1.0;
-  rehash(size, NoKey, 0);
-  allocFactor = 1.3;
+  unsigned s = optsize(max<int>(size, used));
+  if (s != siz)
+    rehash(s);
 }
@@ -1025,6 +1025,38 @@ void IOF30Interface::readCompetitorList(gdioutput &gdi, const xmlobject &xo,
   }
 }
 
+void IOF30Interface::prescanCompetitorList(xmlparser &xml, const wstring &file) {
+  xmlList work;
+  string type;
+  xml.readStream(file, 1, [&](const xmlobject &xCompetitor) {
+    if (xCompetitor.is("Competitor")) {
+      xmlobject person = xCompetitor.getObject("Person");
+      if (person)
+        readIdProviders(person, work, type);
+    }
+  });
+}
+
+void IOF30Interface::readCompetitorList(gdioutput &gdi, xmlparser &xml, const wstring &file,
+                                        bool onlyWithClub, int &personCount, int &duplicateCount) {
+  bool checkVersion = true;
+  unordered_multimap<size_t, int> duplicateCheck;
+  xml.readStream(file, 1, [&](const xmlobject &xCompetitor) {
+    if (checkVersion) {
+      checkVersion = false;
+      string ver;
+      xml.getObject(0).getObjectString("iofVersion", ver);
+      if (!ver.empty() && ver > "3.0")
+        gdi.addString("", 0, "Varning, okänd XML-version X#" + ver);
+    }
+
+    if (xCompetitor.is("Competitor")) {
+      if (readXMLCompetitorDB(xCompetitor, onlyWithClub, duplicateCheck, duplicateCount))
+        personCount++;
+    }
+  });
+}
+
 void IOF30Interface::readClubList(gdioutput &gdi, const xmlobject &xo, int &clubCount) {
   if (!xo)
     return;
@@ -3395,6 +3427,20 @@ void IOF30Interface::writeResultList(xmlparser &xml, const set<int> &classes,
 
   writeEvent(xml);
 
+  xmlparser fragmentXML;
+  if (resultCache) {
+    uint64_t baseKey = getResultCacheBaseKey();
+    if (baseKey != resultCache->baseKey) {
+      resultCache->clear();
+      resultCache->baseKey = baseKey;
+    }
+    resultCache->generation++;
+    resultCache->reused = 0;
+    resultCache->serialized = 0;
+    fragmentXML.openFragmentOutput(xml.skipDefault());
+    fragmentOut = &fragmentXML;
+  }
+
   vector<pClass> c;
   oe.getClasses(c, false);
   vector<pRunner> rToUse;
@@ -3413,6 +3459,119 @@ void IOF30Interface::writeResultList(xmlparser &xml, const set<int> &classes,
   }
 
   xml.endTag();
+
+  if (resultCache) {
+    fragmentOut = nullptr;
+    // Forget runners no longer in the list
+    for (auto it = resultCache->fragments.begin(); it != resultCache->fragments.end();) {
+      if (it->second.generation != resultCache->generation)
+        it = resultCache->fragments.erase(it);
+      else
+        ++it;
+    }
+  }
+}
+
+namespace {
+  inline void hashValue(uint64_t &h, uint64_t v) {
+    h = (h ^ v) * 0x100000001b3ull;
+  }
+}
+
+uint64_t IOF30Interface::getResultCacheBaseKey() {
+  uint64_t h = 0xcbf29ce484222325ull;
+  hashValue(h, useGMT);
+  hashValue(h, teamsAsIndividual);
+  hashValue(h, unrollLoops);
+  hashValue(h, includeStageRaceInfo);
+  hashValue(h, getStageNumber());
+  hashValue(h, oe.getModified().getChangeSerial());
+
+  vector<pClass> cls;
+  oe.getClasses(cls, false);
+  for (pClass c : cls)
+    hashValue(h, c->getModified().getChangeSerial());
+
+  vector<pCourse> crs;
+  oe.getCourses(crs);
+  for (pCourse c : crs)
+    hashValue(h, c->getModified().getChangeSerial());
+
+  vector<pControl> ctrl;
+  oe.getControls(ctrl, false);
+  for (pControl c : ctrl)
+    hashValue(h, c->getModified().getChangeSerial());
+
+  vector<pClub> clubs;
+  oe.getClubs(clubs, false);
+  for (pClub c : clubs)
+    hashValue(h, c->getModified().getChangeSerial());
+
+  return h;
+}
+
+uint64_t IOF30Interface::getResultCacheKey(const oRunner &r, bool includeCourse, bool hasInputTime) const {
+  uint64_t h = 0xcbf29ce484222325ull;
+  hashValue(h, includeCourse);
+  hashValue(h, hasInputTime);
+  vector<pFreePunch> punches;
+  for (int k = 0; k <= r.getNumMulti(); k++) {
+    const pRunner tr = r.getMultiRunner(k);
+    if (!tr)
+      continue;
+    hashValue(h, tr->getId());
+    hashValue(h, tr->getModified().getChangeSerial());
+    if (tr->getCard())
+      hashValue(h, tr->getCard()->getModified().getChangeSerial());
+
+    // Results that depend on other runners
+    hashValue(h, tr->getPlace());
+    hashValue(h, tr->getTimeAfter());
+    hashValue(h, tr->getStatusComputed(true));
+    hashValue(h, tr->getRunningTime(true));
+    hashValue(h, tr->getTotalRunningTime());
+    hashValue(h, tr->getTotalStatus());
+    hashValue(h, tr->getTotalPlace());
+    hashValue(h, int(tr->getDynamicStatus()));
+    pClass cls = tr->getClassRef(true);
+    if (cls)
+      hashValue(h, cls->getTotalLegLeaderTime(oClass::AllowRecompute::Yes, max(tr->getLegNumber(), 0), true, true));
+
+    pTeam t = tr->getTeam();
+    if (t) {
+      int pl = tr->getParResultLeg();
+      hashValue(h, t->getModified().getChangeSerial());
+      hashValue(h, t->getLegPlace(pl, false));
+      hashValue(h, t->getLegRunningTime(pl, true, false));
+      hashValue(h, t->getTimeAfter(pl, true));
+      hashValue(h, t->getLegStatus(pl, true, false));
+    }
+
+    // Radio punches are written for runners without result
+    if (tr->getStatus() == StatusUnknown) {
+      oe.getPunchesForRunner(tr->getId(), false, punches);
+      for (pFreePunch p : punches)
+        hashValue(h, p->getModified().getChangeSerial());
+    }
+  }
+  return h;
+}
+
+void IOF30Interface::writeCachedPersonResult(xmlparser &xml, const oRunner &r,
+                                             bool includeCourse, bool hasInputTime) {
+  uint64_t key = getResultCacheKey(r, includeCourse, hasInputTime);
+  IOFResultCache::Fragment &f = resultCache->fragments[r.getId()];
+  f.generation = resultCache->generation;
+  if (f.key != key || f.xml.empty()) {
+    writePersonResult(*fragmentOut, r, includeCourse, false, hasInputTime);
+    fragmentOut->takeFragment(f.xml);
+    f.key = key;
+    resultCache->serialized++;
+  }
+  else
+    resultCache->reused++;
+
+  xml.writeFragment(f.xml);
 }
 
 void IOF30Interface::writeClassResult(xmlparser &xml,
@@ -3437,7 +3596,10 @@ void IOF30Interface::writeClassResult(xmlparser &xml,
   }
 
   for (size_t k = 0; k < r.size(); k++) {
-    writePersonResult(xml, *r[k], stdCourse == 0, false, hasInputTime);
+    if (fragmentOut)
+      writeCachedPersonResult(xml, *r[k], stdCourse == 0, hasInputTime);
+    else
+      writePersonResult(xml, *r[k], stdCourse == 0, false, hasInputTime);
   }
 
   for (size_t k = 0; k < t.size(); k++) {
@@ -59,6 +59,35 @@ struct XMLService {
   XMLService() {}
 };
 
+/** Serialized PersonResult elements of IOF 3.0 result lists, kept between exports
+    so that only changed runners are serialized again.*/
+class IOFResultCache {
+  struct Fragment {
+    uint64_t key = 0;
+    int generation = 0;
+    string xml;
+  };
+
+  // Key of the data shared by all runners (classes, courses, controls, clubs and settings)
+  uint64_t baseKey = 0;
+  int generation = 0;
+  unordered_map<int, Fragment> fragments;
+
+  int reused = 0;
+  int serialized = 0;
+
+  friend class IOF30Interface;
+public:
+  void clear() {
+    fragments.clear();
+    baseKey = 0;
+  }
+
+  /** Number of reused and serialized runners in the last export.*/
+  int getReused() const { return reused; }
+  int getSerialized() const { return serialized; }
+};
+
 class IOF30Interface {
   oEvent &oe;
 
@@ -239,6 +268,14 @@ class IOF30Interface {
   void writePersonResult(xmlparser &xml, const oRunner &r, bool includeCourse,
                          bool teamMember, bool hasInputTime);
 
+  IOFResultCache *resultCache = nullptr;
+  // Output for runners serialized into the result cache
+  xmlparser *fragmentOut = nullptr;
+
+  uint64_t getResultCacheBaseKey();
+  uint64_t getResultCacheKey(const oRunner &r, bool includeCourse, bool hasInputTime) const;
+  void writeCachedPersonResult(xmlparser &xml, const oRunner &r, bool includeCourse, bool hasInputTime);
+
 
   void writeTeamResult(xmlparser &xml, const oTeam &t, bool hasInputTime);
 
@@ -361,12 +398,20 @@ public:
   void readCompetitorList(gdioutput &gdi, const xmlobject &xo,
                           bool onlyWithClub, int &personCount, int& duplicateCount);
 
+  /** Streaming variants that read a competitor list file one competitor at a time.*/
+  void prescanCompetitorList(xmlparser &xml, const wstring &file);
+  void readCompetitorList(gdioutput &gdi, xmlparser &xml, const wstring &file,
+                          bool onlyWithClub, int &personCount, int &duplicateCount);
+
   void readClubList(gdioutput &gdi, const xmlobject &xo, int &clubCount);
 
   void readCourseData(gdioutput &gdi, const xmlobject &xo,
                       bool updateClasses, int &courseCount, int &entFail, 
                       shared_ptr<MapData>& readMapData);
 
+  /** Reuse serialized runners from earlier exports in writeResultList.*/
+  void setResultCache(IOFResultCache *cache) { resultCache = cache; }
+
   void writeResultList(xmlparser &xml, const set<int> &classes, int leg,
                        bool useUTC, bool teamsAsIndividual, 
                        bool unrollLoops, bool includeStageInfo,
@@ -31,7 +31,7 @@
 #include "meosexception.h"
 #include "liveresult.h"
 
-LiveResult::LiveResult(oEvent *oe) : oe(oe), active(false), lastTime(0), rToWatch(0) {
+LiveResult::LiveResult(oEvent *oe) : oe(oe), active(false), punchCursor(0), rToWatch(0) {
   baseFont = oe->getPropertyString("LiveResultFont", L"Consolas");
   showResultList = -1;
   timerScale = 1.0;
@@ -100,11 +100,11 @@ void LiveResult::showTimer(gdioutput &gdi, const oListInfo &liIn) {
 }
 
 void LiveResult::readoutResult() {
-  lastTime = 0;
+  punchCursor = 0;
   vector<const oFreePunch*> pp;
   oe->synchronizeList({ oListId::oLRunnerId, oListId::oLPunchId });
 
-  oe->getLatestPunches(lastTime, pp);
+  oe->getChangedPunches(punchCursor, pp);
   processedPunches.clear();
 
   map<int, pair<vector<int>, vector<int> > > storedPunches;
@@ -116,7 +116,6 @@ void LiveResult::readoutResult() {
     toPunch = oPunch::PunchFinish;
 
   for (size_t k = 0; k < pp.size(); k++) {
-    lastTime = max(pp[k]->getModificationTime(), lastTime);
     pRunner r = pp[k]->getTiedRunner();
     if (r) {
       pair<int, int> key = make_pair(r->getId(), pp[k]->getControlId());
@@ -167,7 +166,7 @@ void LiveResult::readoutResult() {
 void LiveResult::handle(gdioutput &gdi, BaseInfo &bu, GuiEventType type) {
   if (type == GUI_EVENT) {
     vector<const oFreePunch *> pp;
-    oe->getLatestPunches(lastTime, pp);
+    oe->getChangedPunches(punchCursor, pp);
     
     int fromPunch = li.getParam().useControlIdResultFrom;
     int toPunch = li.getParam().useControlIdResultTo;
@@ -180,7 +179,6 @@ void LiveResult::handle(gdioutput &gdi, BaseInfo &bu, GuiEventType type) {
     vector< pair<int, const oFreePunch*> > enter, exit, backExit;
 
     for (size_t k = 0; k < pp.size(); k++) {
-      lastTime = max(pp[k]->getModificationTime(), lastTime);
       pRunner r = pp[k]->getTiedRunner();
       if (!r)
         continue;
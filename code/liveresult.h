@@ -29,7 +29,7 @@ class LiveResult : public GuiHandler {
   oEvent *oe;
   oListInfo li;
   bool active;
-  unsigned int lastTime;
+  int punchCursor;
   map< pair<int, int>, int > processedPunches;
   vector<int> rToWatch;
   vector<int> watchedR;// Backlog
@@ -23,6 +23,7 @@
 #include "stdafx.h"
 #include <vector>
 #include "meos_util.h"
+#include "xmlscan.h"
 #include "localizer.h"
 #include "oFreeImport.h"
 #include "meosexception.h"
@@ -1078,32 +1079,33 @@ const string &encodeXML(const string &in)
 {
   static string out;
   const char *bf = in.c_str();
-  int len = in.length();
-  bool needEncode = false;
-  for (int k=0;k<len ;k++)
-    needEncode |=  (bf[k]=='&') | (bf[k]=='>') | (bf[k]=='<') | (bf[k]=='"') | (bf[k]==0) | (bf[k]=='\n') | (bf[k]=='\r');
+  const char *end = bf + in.length();
+  const char *esc = scanForXMLEscape(bf, end);
 
-  if (!needEncode)
+  if (esc == end)
     return in;
   out.clear();
-  for (int k=0;k<len ;k++) {
-    if (bf[k]=='&')
+  out.reserve(in.length() + 16);
+  while (esc != end) {
+    out.append(bf, esc);
+    bf = esc;
+    if (*bf=='&')
       out+="&amp;";
-    else if (bf[k]=='<')
+    else if (*bf=='<')
       out+="&lt;";
-    else if (bf[k]=='>')
+    else if (*bf=='>')
       out+="&gt;";
-    else if (bf[k]=='"')
+    else if (*bf=='"')
       out+="&quot;";
-    else if (bf[k]=='\n')
+    else if (*bf=='\n')
       out+="&#10;";
-    else if (bf[k]=='\r')
+    else if (*bf=='\r')
       out+="&#13;";
-    else if (bf[k] == 0)
-      out+=' ';
     else
-      out+=bf[k];
+      out+=' ';
+    esc = scanForXMLEscape(++bf, end);
   }
+  out.append(bf, end);
   return out;
 }
 
@@ -2152,6 +2154,21 @@ wstring getTimeZoneString(const wstring &date) {
   }
 }
 
+void getCollationKey(const wstring &str, string &key) {
+  key.clear();
+  if (str.empty())
+    return;
+
+  // Size in bytes, including terminating zero
+  int len = LCMapStringW(LOCALE_USER_DEFAULT, LCMAP_SORTKEY, str.c_str(), str.length(), nullptr, 0);
+  if (len <= 1)
+    return;
+
+  key.resize(len);
+  LCMapStringW(LOCALE_USER_DEFAULT, LCMAP_SORTKEY, str.c_str(), str.length(), (LPWSTR)&key[0], len);
+  key.pop_back();
+}
+
 bool compareBib(const wstring &b1, const wstring &b2) {
   int l1 = b1.length();
   int l2 = b2.length();
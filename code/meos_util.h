@@ -279,6 +279,20 @@ int getTimeZoneInfo(const wstring &date);
 /** Compare bib numbers (which may contain non-digits, e.g. A-203, or 301a, 301b)*/
 bool compareBib(const wstring &b1, const wstring &b2);
 
+/** Compute a collation key for a string. Comparing keys as byte strings gives the same
+    order as CompareString with LOCALE_USER_DEFAULT. */
+void getCollationKey(const wstring &str, string &key);
+
+/** Collation key of a name. The owner updates the key when the name changes, so get is a
+    plain read that can be used on any thread. Keys compare with operator< (memcmp) in the same
+    order as CompareString. */
+class CollationKey {
+  string key;
+public:
+  const string &get() const { return key; }
+  void update(const wstring &name) { getCollationKey(name, key); }
+};
+
 /** Split a name into Given, Family, and return Given.*/
 wstring getGivenName(const wstring &name);
 
@@ -27,8 +27,9 @@
 
 #include "oBase.h"
 #include "oPunch.h"
+#include "chunkallocator.h"
 
-typedef list<oPunch> oPunchList;
+typedef list<oPunch, ChunkAllocator<oPunch>> oPunchList;
 
 class gdioutput;
 class oCard;
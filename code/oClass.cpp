@@ -564,6 +564,7 @@ void oClass::setCourse(pCourse c)
 void oClass::setName(const wstring &name, bool manualSet) {
   if (getName() != name) {
     Name = name;
+    tNameKey.update(Name);
     if (manualSet)
       setFlag(TransferFlags::FlagManualName, true);
     updateChanged();
@@ -776,6 +777,7 @@ pClass oEvent::addClass(const wstring &pname, int CourseId, int classId)
 
   Classes.push_back(c);
   Classes.back().addToEvent(this, &c);
+  Classes.back().tNameKey.update(Classes.back().Name);
   Classes.back().synchronize();
   updateTabs();
   return &Classes.back();
@@ -793,6 +795,7 @@ pClass oEvent::addClass(const oClass &c)
 
   Classes.push_back(c);
   Classes.back().addToEvent(this, &c);
+  Classes.back().tNameKey.update(Classes.back().Name);
 
   if (hasDBConnection() && !Classes.back().existInDB() && !c.isImplicitlyCreated()) {
     Classes.back().changed = true;
@@ -4018,9 +4021,11 @@ void oClass::markSQLChanged(int leg, int control) {
 }
 
 void oClass::changedObject() {
+  tNameKey.update(Name);
   markSQLChanged(-1,-1);
   tNoTiming = -1;
   tIgnoreStartPunch = -1;
+  oe->sqlChangedClasses.insert(Id);
   oe->sqlClasses.changed = true;
 }
 
@@ -27,6 +27,7 @@
 #include <map>
 #include <unordered_map>
 #include "inthashmap.h"
+#include "meos_util.h"
 class oClass;
 typedef oClass* pClass;
 class oDataInterface;
@@ -167,6 +168,7 @@ public:
 
 protected:
   wstring Name;
+  CollationKey tNameKey;
   pCourse Course;
 
   vector<vector<pCourse>> MultiCourse;
@@ -698,6 +700,8 @@ public:
   int getNumberMaps(bool rawAttribute = false) const;
 
   const wstring &getName() const {return Name;}
+  /** Key for locale ordered comparison of names.*/
+  const string &getNameKey() const {return tNameKey.get();}
   void setName(const wstring &name, bool manualSet);
 
   const wstring& getLongName() const;
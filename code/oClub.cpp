@@ -152,6 +152,7 @@ void oClub::set(const xmlobject& xo) {
 
 void oClub::internalSetName(const wstring &n) {
   name = n;
+  tNameKey.update(name);
   const wchar_t *bf = name.c_str();
   int len = name.length();
   int ix = -1;
@@ -350,6 +351,7 @@ pClub oEvent::addClub(const oClub &oc)
 
   Clubs.push_back(oc);
   Clubs.back().addToEvent(this, &oc);
+  Clubs.back().tNameKey.update(Clubs.back().name);
 
   if (!oc.existInDB())
     Clubs.back().synchronize();
@@ -1235,15 +1237,14 @@ int oClub::getFirstInvoiceNumber(oEvent &oe) {
 }
 
 void oClub::changedObject() {
+  tNameKey.update(name);
   if (oe)
     oe->globalModification = true;
   oe->sqlClubs.changed = true;
 }
 
 bool oClub::operator<(const oClub &c) const {
-  return CompareString(LOCALE_USER_DEFAULT, 0,
-                      name.c_str(), name.length(),
-                      c.name.c_str(), c.name.length()) == CSTR_LESS_THAN;
+  return getNameKey() < c.getNameKey();
 }
 
 wstring oClub::getInvoiceDate(oEvent &oe) {
@@ -27,6 +27,7 @@
 
 #include <map>
 #include "oBase.h"
+#include "meos_util.h"
 
 class oEvent;
 
@@ -59,6 +60,7 @@ protected:
   };
 
   wstring name;
+  CollationKey tNameKey;
   vector<wstring> altNames;
   wstring tPrettyName;
   wstring tCompactName;
@@ -188,6 +190,8 @@ public:
   int getDataAmount() const;
 
   const wstring &getName() const {return name;}
+  /** Key for locale ordered comparison of names.*/
+  const string &getNameKey() const {return tNameKey.get();}
 
   const wstring &getDisplayName() const {return tPrettyName.empty() ?  name : tPrettyName;}
 
@@ -322,7 +322,7 @@ bool oControl::setNumbers(const wstring &numbers)
 
   if (nNumbers!=nn || memcmp(bf, Numbers, sizeof(int)*nNumbers)!=0) {
     updateChanged();
-    oe->punchIndex.clear();
+    oe->clearPunchIndex();
   }
 
   return success;
@@ -1033,10 +1033,14 @@ void oControl::getNumbers(vector<int> &numbers) const {
 }
 
 void oControl::changedObject() {
-  if (oe)
-    oe->globalModification = true;
-
-  oe->sqlControls.changed = true;
+  if (oe) {
+    // With a database, the dependent classes are marked as changed by oEvent::reEvaluateChanged
+    if (oe->hasDBConnection())
+      oe->sqlChangedControls.insert(Id);
+    else
+      oe->globalModification = true;
+    oe->sqlControls.changed = true;
+  }
 }
 
 int oControl::getNumberDuplicates() const {
@@ -311,7 +311,7 @@ bool oCourse::importControls(const string& ctrls, bool setChanged, bool updateLe
     if (setChanged)
       updateChanged();
 
-    oe->punchIndex.clear();
+    oe->clearPunchIndex();
   }
 
   return changed;
@@ -1349,9 +1349,14 @@ bool oCourse::constructLoopKeys(int cc, vector< vector<pControl> > &loopKeys, ve
 }
 
 void oCourse::changedObject() {
-  if (oe)
-    oe->globalModification = true;
-  oe->sqlCourses.changed = true;
+  if (oe) {
+    // With a database, the dependent classes are marked as changed by oEvent::reEvaluateChanged
+    if (oe->hasDBConnection())
+      oe->sqlChangedCourses.insert(Id);
+    else
+      oe->globalModification = true;
+    oe->sqlCourses.changed = true;
+  }
 }
 
 int oCourse::getCourseControlId(int controlIx) const {
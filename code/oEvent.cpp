@@ -27,6 +27,7 @@
 #include <cassert>
 #include <algorithm>
 #include <limits>
+#include <execution>
 
 #include "oEvent.h"
 #include "gdioutput.h"
@@ -1239,14 +1240,20 @@ bool oEvent::open(const wstring &file, bool doImport, bool forMerge, bool forceN
 void oEvent::clearData(bool runnerTeam, bool courses) {
   Cards.clear();
 
-  list<oFreePunch> op;
+  oFreePunchList op;
   for (auto& p : punches) {
     if (p.isHiredCard())
       op.push_back(p);
   }
-  punchIndex.clear();
+  clearPunchIndex();
+  punchById.clear();
+  clearPunchLog();
   punches.clear();
   punches.swap(op);
+  for (auto &p : punches) {
+    punchById[p.Id] = &p;
+    addToPunchLog(p);
+  }
 
   if (courses) {
     Controls.clear();
@@ -1283,6 +1290,7 @@ void oEvent::clearData(bool runnerTeam, bool courses) {
   classIdToRunnerHash.reset();
   classIdToRunnerHash.reset();
   readPunchHash.clear();
+  readPunchHashExtra.clear();
   courseIdIndex.clear();
   updateFreeId();
 }
@@ -1391,6 +1399,7 @@ bool oEvent::open(const xmlparser &xml, const wstring &fileArg) {
         if (c.Id>0 && knownClass.count(c.Id) == 0) {
           Classes.push_back(c);
           Classes.back().addToEvent(this, &c);
+          Classes.back().tNameKey.update(Classes.back().Name);
           knownClass.insert(c.Id);
         }
       }
@@ -2005,6 +2014,7 @@ pRunner oEvent::addRunner(const oRunner &r, bool updateStartNo) {
   Runners.push_back(r);
   pRunner pr=&Runners.back();
   pr->addToEvent(this, &r);
+  pr->tNameKey.update(pr->tRealName);
 
   for (size_t i = 0; i < pr->multiRunner.size(); i++) {
     if (pr->multiRunner[i]) {
@@ -2334,30 +2344,132 @@ pCard oEvent::allocateCard(pRunner owner)
   return newCard;
 }
 
+namespace {
+  // Use a parallel sort above this number of runners
+  const size_t parallelSortLimit = 5000;
+
+  /** Buffers for key sorting, kept per thread to avoid reallocation.*/
+  struct RunnerSortBuffer {
+    vector<RunnerSortKey> keys;
+    vector<int> rank;
+    vector<int> order;
+    vector<const string *> nameKey;
+  };
+
+  /** Compute the sorted order of runners (as indices into runners) for a sort order supported by sort keys.
+      Only reads the runners (name keys included) and uses per thread buffers. It can run on any
+      thread, provided the runners are not modified meanwhile.*/
+  template<typename R>
+  const vector<RunnerSortKey> &getRunnerOrder(SortOrder so, const vector<R> &runners) {
+    thread_local RunnerSortBuffer buffer;
+    const int n = runners.size();
+    vector<int> &rank = buffer.rank;
+    vector<int> &order = buffer.order;
+    rank.assign(n, 0);
+    order.resize(n);
+
+    if (so == ClassStartTime) {
+      // Rank runners by bib
+      for (int i = 0; i < n; i++)
+        order[i] = i;
+      sort(order.begin(), order.end(), [&runners](int a, int b) {
+        return compareBib(runners[a]->getBib(), runners[b]->getBib());
+      });
+      for (int i = 1; i < n; i++) {
+        bool same = runners[order[i]]->getBib() == runners[order[i - 1]]->getBib();
+        rank[order[i]] = same ? rank[order[i - 1]] : i;
+      }
+    }
+
+    vector<RunnerSortKey> &keys = buffer.keys;
+    keys.resize(n);
+    bool useName = false;
+    for (int i = 0; i < n; i++) {
+      runners[i]->getSortKey(so, rank[i], keys[i]);
+      keys[i].index = i;
+      useName |= keys[i].nameRank != 0;
+    }
+
+    if (useName) {
+      // Rank runners by the collation keys of their names
+      vector<const string *> &nameKey = buffer.nameKey;
+      nameKey.resize(n);
+      int m = 0;
+      for (int i = 0; i < n; i++) {
+        if (keys[i].nameRank != 0) {
+          nameKey[i] = &runners[i]->getNameKey();
+          order[m++] = i;
+        }
+      }
+      sort(order.begin(), order.begin() + m, [&nameKey](int a, int b) {
+        return *nameKey[a] < *nameKey[b];
+      });
+      for (int i = 0; i < m; i++) {
+        bool same = i > 0 && *nameKey[order[i]] == *nameKey[order[i - 1]];
+        keys[order[i]].nameRank = same ? keys[order[i - 1]].nameRank : i + 1;
+      }
+    }
+
+    if (keys.size() >= parallelSortLimit)
+      sort(std::execution::par, keys.begin(), keys.end());
+    else
+      sort(keys.begin(), keys.end());
+
+    return keys;
+  }
+
+  template<typename R>
+  void sortRunnerVector(SortOrder so, vector<R> &runners) {
+    if (!oRunner::hasSortKey(so)) {
+      sort(runners.begin(), runners.end(), [so](const R &a, const R &b)->bool {return a->lessThan(*b, so); });
+      return;
+    }
+
+    const vector<RunnerSortKey> &keys = getRunnerOrder(so, runners);
+    vector<R> sorted;
+    sorted.reserve(runners.size());
+    for (const RunnerSortKey &k : keys)
+      sorted.push_back(runners[k.index]);
+    runners.swap(sorted);
+  }
+}
+
 bool oEvent::sortRunners(SortOrder so) {
   reinitializeClasses();
   if (so == Custom)
     return false;
   CurrentSortOrder=so;
-  Runners.sort();
+  if (!oRunner::hasSortKey(so)) {
+    Runners.sort();
+    return true;
+  }
+
+  vector<oRunner *> runners;
+  vector<oRunnerList::iterator> pos;
+  runners.reserve(Runners.size());
+  pos.reserve(Runners.size());
+  for (auto it = Runners.begin(); it != Runners.end(); ++it) {
+    runners.push_back(&*it);
+    pos.push_back(it);
+  }
+
+  // Move the runners to the end of the list in sorted order. The runners are not copied.
+  const vector<RunnerSortKey> &keys = getRunnerOrder(so, runners);
+  for (const RunnerSortKey &k : keys)
+    Runners.splice(Runners.end(), Runners, pos[k.index]);
+
   return true;
 }
 
 bool oEvent::sortRunners(SortOrder so, vector<const oRunner *> &runners) const {
   reinitializeClasses();
-  auto oldSortOrder = CurrentSortOrder;
-  CurrentSortOrder = so;
-  sort(runners.begin(), runners.end(), [](const oRunner * &a, const oRunner * &b)->bool {return *a < *b; });
-  CurrentSortOrder = oldSortOrder;
+  sortRunnerVector(so, runners);
   return true;
 }
 
 bool oEvent::sortRunners(SortOrder so, vector<pRunner> &runners) const {
   reinitializeClasses();
-  auto oldSortOrder = CurrentSortOrder;
-  CurrentSortOrder = so;
-  sort(runners.begin(), runners.end(), [](pRunner &a, pRunner &b)->bool {return *a < *b; });
-  CurrentSortOrder = oldSortOrder;
+  sortRunnerVector(so, runners);
   return true;
 }
 
@@ -4274,7 +4386,9 @@ void oEvent::clear()
   Clubs.clear();
   clubIdIndex.clear();
 
-  punchIndex.clear();
+  clearPunchIndex();
+  punchById.clear();
+  clearPunchLog();
   punches.clear();
   cachedFirstStart.clear();
   hiredCardHash.clear();
@@ -4306,6 +4420,7 @@ void oEvent::clear()
   tCurrencyPreSymbol = false;
 
   readPunchHash.clear();
+  readPunchHashExtra.clear();
 
   //Reset speaker data structures.
   listContainer->clearExternal();
@@ -4426,6 +4541,16 @@ void oEvent::reEvaluateCourse(int CourseId, bool doSync)
 }
 
 void oEvent::reEvaluateAll(const set<int> &cls, bool doSync)
+{
+  if (disableRecalculate)
+    return;
+
+  EvaluationStatistics stat;
+  reEvaluateAll(cls, doSync, stat);
+  addEvaluation(stat);
+}
+
+void oEvent::reEvaluateAll(const set<int> &cls, bool doSync, EvaluationStatistics &stat)
 {
   if (disableRecalculate)
     return;
@@ -4438,6 +4563,7 @@ void oEvent::reEvaluateAll(const set<int> &cls, bool doSync)
       it->clearSplitAnalysis();
       it->resetLeaderTime();
       it->reinitialize(true);
+      stat.classes++;
     }
   }
 
@@ -4447,6 +4573,7 @@ void oEvent::reEvaluateAll(const set<int> &cls, bool doSync)
 
     if (!tit->isRemoved()) {
       tit->apply(ChangeType::Quiet, nullptr);
+      stat.teams++;
     }
   }
   oRunnerList::iterator it;
@@ -4471,26 +4598,7 @@ void oEvent::reEvaluateAll(const set<int> &cls, bool doSync)
     }
   }
 
-  vector<pair<int, pControl>> mp;
-  bool needupdate = true;
-  int leg = 0;
-  while (needupdate) {
-    needupdate = false;
-    for (it=Runners.begin(); it != Runners.end(); ++it) {
-      if (!cls.empty() && cls.count(it->getClassId(true)) == 0)
-         continue;
-
-      if (!it->isRemoved()) {
-        if (it->tLeg == leg) {
-          it->evaluateCard(false, mp, 0, ChangeType::Quiet); // Must not sync!
-          it->storeTimes();
-        }
-        else if (it->tLeg>leg)
-          needupdate = true;
-      }
-    }
-    leg++;
-  }
+  stat.runners += evaluateCardsByLeg(cls);
 
   // Mark info as complete
   for (auto& c : Classes) {
@@ -4522,23 +4630,134 @@ void oEvent::reEvaluateAll(const set<int> &cls, bool doSync)
   //reCalculateLeaderTimes(0);
 }
 
+void oEvent::addEvaluation(const EvaluationStatistics &stat) {
+  lastEvaluation = stat;
+  totalEvaluation.classes += stat.classes;
+  totalEvaluation.teams += stat.teams;
+  totalEvaluation.runners += stat.runners;
+#ifdef _DEBUG
+  OutputDebugStringA(("Evaluated " + itos(stat.classes) + " classes, " + itos(stat.teams) + 
+                      " teams, " + itos(stat.runners) + " runners\n").c_str());
+#endif
+}
+
+void oEvent::getDependentClasses(const set<int> &controls, const set<int> &courses, set<int> &classes) const {
+  set<int> crsId = courses;
+  if (!controls.empty()) {
+    for (auto &crs : Courses) {
+      if (crs.isRemoved())
+        continue;
+      for (pControl ctrl : crs.controls) {
+        if (ctrl && controls.count(ctrl->getId())) {
+          crsId.insert(crs.getId());
+          break;
+        }
+      }
+    }
+  }
+
+  if (crsId.empty())
+    return;
+
+  // A course is also affected by a change of one of its shorter versions
+  for (auto &c : Courses) {
+    if (c.isRemoved() || crsId.count(c.getId()))
+      continue;
+    int maxIter = 10;
+    pCourse shorter = c.getShorterVersion().second;
+    while (shorter && --maxIter >= 0) {
+      if (crsId.count(shorter->getId())) {
+        crsId.insert(c.getId());
+        break;
+      }
+      shorter = shorter->getShorterVersion().second;
+    }
+  }
+
+  vector<pCourse> crs;
+  for (auto &c : Classes) {
+    if (c.isRemoved() || classes.count(c.getId()))
+      continue;
+    c.getCourses(-1, crs);
+    for (pCourse pc : crs) {
+      if (crsId.count(pc->getId())) {
+        classes.insert(c.getId());
+        break;
+      }
+    }
+  }
+
+  for (auto &r : Runners) {
+    if (!r.isRemoved() && r.Course && crsId.count(r.Course->getId()))
+      classes.insert(r.getClassId(true));
+  }
+}
+
+int oEvent::evaluateCardsByLeg(const set<int> &cls) {
+  // Runners on a leg depend on the results of earlier legs. Collect the runners once
+  // and evaluate them leg by leg, in list order within each leg.
+  vector<pRunner> runners;
+  for (oRunner &r : Runners) {
+    if (r.isRemoved() || r.tLeg < 0)
+      continue;
+    if (!cls.empty() && cls.count(r.getClassId(true)) == 0)
+      continue;
+    runners.push_back(&r);
+  }
+
+  stable_sort(runners.begin(), runners.end(), [](const pRunner &a, const pRunner &b) {
+    return a->tLeg < b->tLeg;
+  });
+
+  vector<pair<int, pControl>> mp;
+  for (pRunner r : runners) {
+    r->evaluateCard(false, mp, 0, ChangeType::Quiet); // Must not sync!
+    r->storeTimes();
+  }
+  return runners.size();
+}
+
 void oEvent::reEvaluateChanged()
 {
+  EvaluationStatistics stat;
+  // Classes evaluated due to a changed class, course or control
+  set<int> evaluated;
   if (sqlClasses.changed || sqlCourses.changed || sqlControls.changed) {
-    reEvaluateAll(set<int>(), false);
-    globalModification = true;
-    return;
+    if ((sqlClasses.changed && sqlChangedClasses.empty()) ||
+        (sqlCourses.changed && sqlChangedCourses.empty()) ||
+        (sqlControls.changed && sqlChangedControls.empty())) {
+      // Unknown change
+      reEvaluateAll(set<int>(), false);
+      globalModification = true;
+      return;
+    }
+
+    evaluated = sqlChangedClasses;
+    getDependentClasses(sqlChangedControls, sqlChangedCourses, evaluated);
+    for (int id : evaluated) {
+      pClass cls = getClass(id);
+      if (cls)
+        cls->markSQLChanged(-1, -1);
+    }
+    if (!evaluated.empty())
+      reEvaluateAll(evaluated, false, stat);
   }
 
   if (sqlClubs.changed)
     globalModification = true;
 
 
-  if (!sqlCards.changed && !sqlRunners.changed && !sqlTeams.changed)
-    return; // Nothing to do
+  if (!sqlCards.changed && !sqlRunners.changed && !sqlTeams.changed) {
+    // Nothing more to do
+    if (!evaluated.empty())
+      addEvaluation(stat);
+    return;
+  }
 
   map<int, bool> resetClasses;
   for(oClassList::iterator it=Classes.begin();it!=Classes.end();++it)  {
+    if (evaluated.count(it->getId()))
+      continue;
     if (it->wasSQLChanged(-1, oPunch::PunchFinish)) {
       it->clearSplitAnalysis();
       it->resetLeaderTime();
@@ -4551,7 +4770,7 @@ void oEvent::reEvaluateChanged()
   unordered_set<int> addedTeams;
 
   for(oTeamList::iterator tit=Teams.begin();tit!=Teams.end();++tit) {
-    if (tit->isRemoved() || !tit->wasSQLChanged())
+    if (tit->isRemoved() || !tit->wasSQLChanged() || evaluated.count(tit->getClassId(false)))
       continue;
 
     addedTeams.insert(tit->getId());
@@ -4570,7 +4789,9 @@ void oEvent::reEvaluateChanged()
       //if (resetClasses.count(clz))
       //  it->storeTimes();
 
-      if (!it->wasSQLChanged() && !resetClasses[clz])
+      auto reset = resetClasses.find(clz);
+      bool globalReset = reset != resetClasses.end() && reset->second;
+      if ((!it->wasSQLChanged() && !globalReset) || evaluated.count(clz))
         continue;
 
       pTeam t = it->tInTeam;
@@ -4583,7 +4804,7 @@ void oEvent::reEvaluateChanged()
 
   for (it=Runners.begin(); it != Runners.end(); ++it) {
     pRunner r = &*it;
-    if (r->isRemoved())
+    if (r->isRemoved() || evaluated.count(r->getClassId(true)))
       continue;
 
     if (r->wasSQLChanged() || (r->tInTeam && addedTeams.count(r->tInTeam->getId()))) {
@@ -4614,6 +4835,7 @@ void oEvent::reEvaluateChanged()
     for (size_t k = 0; k < lr.size(); k++) {
       lr[k]->evaluateCard(false, mp, 0, ChangeType::Quiet); // Must not sync!
     }
+    stat.runners += lr.size();
   }
 
   for(oTeamList::iterator tit=Teams.begin();tit!=Teams.end();++tit) {
@@ -4630,6 +4852,10 @@ void oEvent::reEvaluateChanged()
       lr[k]->clearOnChangedRunningTime();
     }
   }
+
+  stat.classes += resetClasses.size();
+  stat.teams += addedTeams.size();
+  addEvaluation(stat);
 }
 
 void oEvent::reCalculateLeaderTimes(int classId)
@@ -5473,7 +5699,7 @@ bool compareClubClassTeamName(const oRunner &a, const oRunner &b)
   if (a.Club==b.Club) {
     if (a.getClassId(true) == b.getClassId(true)) {
       if (a.tInTeam==b.tInTeam)
-        return a.tRealName<b.tRealName;
+        return a.getNameKey() < b.getNameKey();
       else if (a.tInTeam) {
         if (b.tInTeam)
           return a.tInTeam->getStartNo() < b.tInTeam->getStartNo();
@@ -5481,11 +5707,19 @@ bool compareClubClassTeamName(const oRunner &a, const oRunner &b)
       }
       return b.tInTeam!=0;
     }
-    else
-      return a.getClass(true)<b.getClass(true);
+    else {
+      pClass ca = a.getClassRef(true);
+      pClass cb = b.getClassRef(true);
+      if (!ca || !cb)
+        return cb != nullptr;
+      return ca->getNameKey() < cb->getNameKey();
+    }
+  }
+  else {
+    if (!a.Club || !b.Club)
+      return b.Club != nullptr;
+    return a.Club->getNameKey() < b.Club->getNameKey();
   }
-  else
-    return a.getClub()<b.getClub();
 }
 
 void oEvent::assignCardInteractive(gdioutput& gdi, GUICALLBACK cb, SortOrder& orderRunners)
@@ -78,6 +78,7 @@ class MeosSQL;
 class MachineContainer;
 class MapDataContainer;
 class MapData;
+class IOFResultCache;
 
 struct oCounter {
   int level1;
@@ -139,11 +140,12 @@ typedef list<oControl> oControlList;
 typedef list<oCourse> oCourseList;
 typedef list<oClass> oClassList;
 typedef list<oClub> oClubList;
-typedef list<oRunner> oRunnerList;
-typedef list<oCard> oCardList;
-typedef list<oTeam> oTeamList;
+// Runners, teams, cards and punches are many. Their nodes are allocated in chunks.
+typedef list<oRunner, ChunkAllocator<oRunner>> oRunnerList;
+typedef list<oCard, ChunkAllocator<oCard>> oCardList;
+typedef list<oTeam, ChunkAllocator<oTeam>> oTeamList;
 
-typedef list<oFreePunch> oFreePunchList;
+typedef list<oFreePunch, ChunkAllocator<oFreePunch>> oFreePunchList;
 
 struct ClassInfo;
 struct DrawInfo;
@@ -302,6 +304,38 @@ protected:
   /** First level maps a constant based on control number
       and index on course to a second maps, that maps cardNo to punches. */
   map<int, PunchIndexType> punchIndex;
+  /** Maps cardNo to the indexed punches of the card, sorted by time.
+      Contains the same punches as punchIndex. */
+  unordered_map<int, vector<pFreePunch>> cardPunchIndex;
+  void clearPunchIndex() {
+    punchIndex.clear();
+    cardPunchIndex.clear();
+  }
+  /** Remove a punch from punchIndex and cardPunchIndex.*/
+  void removeFromPunchIndex(pFreePunch punch);
+  intkeymap<pFreePunch> punchById;
+
+  struct PunchLogEntry {
+    // Modification time, raised if needed to keep the log sorted
+    unsigned int time;
+    // Sequence number of the entry, used as cursor
+    int serial;
+    // Null if the punch was changed again or removed
+    pFreePunch punch;
+  };
+  /** Free punches and advance information punches in order of modification.
+      A punch has one entry, the latest.*/
+  vector<PunchLogEntry> punchLog;
+  int punchLogSerial = 0;
+  int punchLogUnused = 0;
+  void addToPunchLog(oFreePunch &punch);
+  void removeFromPunchLog(oFreePunch &punch);
+  void clearPunchLog();
+
+  /** Create a free punch without hashing it.*/
+  pFreePunch createFreePunch(int time, int type, int unit, int card, bool isOriginal);
+  /** Send, store and apply a free punch after it has been hashed.*/
+  void processFreePunch(pFreePunch fp, bool updateRunner);
 
   /** Defined map from a pair (type, unit) of punches to a time adjustment (for that unit)*/
   mutable pair<int, map<pair<oPunch::SpecialPunch, int>, int>> typeUnitPunchTimeAdjustment;
@@ -329,6 +363,11 @@ protected:
   SqlUpdated sqlPunches;
   SqlUpdated sqlTeams;
 
+  // Ids of controls, courses and classes changed since the last reset
+  set<int> sqlChangedControls;
+  set<int> sqlChangedCourses;
+  set<int> sqlChangedClasses;
+
   bool needReEvaluate();
 
   DirectSocket *directSocket = nullptr;
@@ -398,8 +437,21 @@ protected:
 
   multimap<int, oTimeLine> timeLineEvents;
   int timeLineRevision = -1;
-  set<int> timelineClasses;
+
+  // A watched class in the speaker timeline
+  struct TimeLineClass {
+    int nextEvent = 0; // Time when the events of the class must be recomputed
+    vector<TimeLineIterator> events; // The events of the class in timeLineEvents
+  };
+  map<int, TimeLineClass> timelineClasses;
   set<int> modifiedClasses;
+  // Class being set up, which gets inserted events
+  TimeLineClass *timeLineSetupClass = nullptr;
+  // Slowest timeline refresh (microseconds)
+  int timeLineMaxRefreshTime = 0;
+
+  TimeLineIterator insertTimeLineEvent(int time, const oTimeLine &tl);
+  void eraseTimeLineEvents(TimeLineClass &tlc);
 
   static const int dataSize = 1024;
   int getDISize() const final {return dataSize;}
@@ -422,7 +474,14 @@ protected:
 
   DataRevisionCache<int> scoreFactor;
 
-  set<pair<int,int>> readPunchHash;
+  /** Read punches, for detecting duplicates. Keyed by time and card number,
+      with the code as value. A punch with the same time and card as a punch
+      in readPunchHash, but another code, is stored in readPunchHashExtra. */
+  intkeymap<int, __int64> readPunchHash;
+  set<pair<__int64, int>> readPunchHashExtra;
+  static __int64 getPunchHashKey(int card, int time) {
+    return (__int64(time) << 32) | unsigned(card);
+  }
   void insertIntoPunchHash(int card, int code, int time);
   void removeFromPunchHash(int card, int code, int time);
   bool isInPunchHash(int card, int code, int time);
@@ -452,7 +511,7 @@ protected:
   void analyzeClassResultStatus() const;
 
   /// Implementation versions
-  int setupTimeLineEvents(int classId, int currentTime);
+  int setupTimeLineEvents(int classId, const vector<pRunner> &classRunners, int currentTime);
   int setupTimeLineEvents(vector<pRunner> &started, const vector< pair<int, pControl> > &rc, int currentTime, bool finish);
   void timeLinePrognose(TempResultMap &result, TimeRunner &tr, int prelT,
                         int radioNumber, const wstring &rname, int radioId);
@@ -594,6 +653,10 @@ public:
   /// Get new punches since firstTime
   void getLatestPunches(int firstTime, vector<const oFreePunch *> &punches) const;
 
+  /** Get punches added or changed since the cursor was last used, and advance the cursor.
+      Start with cursor 0 to get all punches.*/
+  void getChangedPunches(int &cursor, vector<const oFreePunch *> &punches) const;
+
   void resetSQLChanged(bool resetAllTeamsRunners, bool cleanClasses);
 
   void pushDirectChange();
@@ -882,6 +945,17 @@ public:
   pFreePunch addFreePunch(int time, int type, int unit, int card, bool updateRunner, bool isOriginal);
   pFreePunch addFreePunch(oFreePunch &fp);
 
+  struct FreePunchInput {
+    int time;
+    int type;
+    int unit;
+    int card;
+    bool isOriginal;
+  };
+  /** Add a batch of punches. Punches already added are skipped, and each card
+      is rehashed once. Returns the number of added punches. */
+  int addFreePunches(const vector<FreePunchInput> &input, bool updateRunner);
+
   bool useLongTimes() const;
   void useLongTimes(bool use);
 
@@ -915,6 +989,62 @@ public:
   };
 
   void getResultEvents(const set<int> &classFilter, const set<int> &controlFilter, vector<ResultEvent> &results) const;
+  /** Get the result events of the given runners, as computed by getResultEvents. Classes
+      with parallel or optional legs are not supported (see getResultEventRunners).*/
+  void getResultEvents(const set<int> &runnerIds, const set<int> &controlFilter, vector<ResultEvent> &results) const;
+
+  /** A new radio punch, finish or readout of a runner. The revisions bracket the data change,
+      so that a subscriber can tell if the notices account for all changes.*/
+  struct ResultEventNotice {
+    int runnerId = 0; // Zero for a change outside the class filter of the subscription
+    int controlId = 0;
+    int time = 0;
+    long revisionBefore = 0;
+    long revisionAfter = 0;
+  };
+
+  /** Subscribe to result event notices of the given classes (all classes if empty). At most
+      capacity notices are buffered between reads. Returns the subscription id.*/
+  int subscribeResultEvents(const set<int> &classFilter, int capacity);
+  void unsubscribeResultEvents(int subscriptionId);
+
+  /** Take the buffered notices of a subscription. Returns false if notices were lost or if they
+      do not account for all data changes since revision; then all result events must be recomputed.
+      The revision is updated to the current data revision.*/
+  bool takeResultEventNotices(int subscriptionId, long &revision, vector<ResultEventNotice> &notices);
+
+  /** Get the runners whose result events may have changed by the notices, including following legs
+      of their teams. Returns false if a class with parallel or optional legs is affected.*/
+  bool getResultEventRunners(const vector<ResultEventNotice> &notices, set<int> &runnerIds) const;
+
+  /** Notify subscribers of a new result event of the runner (nullptr for other changes).*/
+  void pushResultEvent(const oRunner *r, int controlId, int time, long revisionBefore);
+
+protected:
+  // Ordered ring buffer of result event notices for a subscriber
+  struct ResultEventFeed {
+    set<int> classFilter;
+    vector<ResultEventNotice> buffer;
+    size_t first = 0;
+    size_t count = 0;
+    bool lost = false; // Buffer overflow since last read
+  };
+  map<int, ResultEventFeed> resultEventFeeds;
+  int resultEventFeedId = 0;
+
+  void addRunnerResultEvents(const oRunner &r, RunnerStatus prevLegStatus,
+                             const set<int> &punchFilter, vector<ResultEvent> &results) const;
+  void addPunchResultEvent(const oFreePunch &fp, const oRunner &r, RunnerStatus prevLegStatus,
+                           const set<int> &punchFilter, vector<ResultEvent> &results) const;
+
+public:
+
+  /** Number of objects evaluated by reEvaluateAll and reEvaluateChanged.*/
+  struct EvaluationStatistics {
+    int classes = 0;
+    int teams = 0;
+    int runners = 0;
+  };
 
   /** Compute results for split times while runners are on course.*/
   void computePreliminarySplitResults(const set<int> &classes) const;
@@ -961,10 +1091,21 @@ protected:
   mutable int tLongTimesCached;
   mutable map<int, pair<int, int> > cachedFirstStart; //First start by key (see usage).
   map<pair<int, int>, oFreePunch> advanceInformationPunches;
+  void clearAdvancePunchInformation();
 
   bool calculateTeamResults(vector<const oTeam*> &teams, int leg, ResultType resultType);
   void calculateModuleTeamResults(const set<int> &cls, vector<oTeam *> &teams);
 
+  /** Evaluate the cards of the runners in the given classes (all if empty), leg by leg.
+      Returns the number of evaluated runners.*/
+  int evaluateCardsByLeg(const set<int> &cls);
+
+  EvaluationStatistics lastEvaluation;
+  EvaluationStatistics totalEvaluation;
+  void addEvaluation(const EvaluationStatistics &stat);
+  /** Reevaluate the classes (all if empty). The evaluated objects are added to stat.*/
+  void reEvaluateAll(const set<int> &classId, bool doSync, EvaluationStatistics &stat);
+
   unsigned int lastTimeConsistencyCheck = 0;
   mutable bool lastResultCalcPrelState = false;
   mutable bool lastResultCalcSplitResult = false;
@@ -1062,6 +1203,13 @@ public:
   void reEvaluateAll(const set<int> &classId, bool doSync);
   void reEvaluateChanged();
 
+  /** Add the classes depending on the given controls or courses: classes with a course
+      using a control, and classes with a runner assigned to such a course.*/
+  void getDependentClasses(const set<int> &controls, const set<int> &courses, set<int> &classes) const;
+
+  const EvaluationStatistics &getLastEvaluation() const { return lastEvaluation; }
+  const EvaluationStatistics &getTotalEvaluation() const { return totalEvaluation; }
+
   void exportIOFSplits(IOFVersion version, const wchar_t *file, bool oldStylePatrolExport,
                        bool useUTC,
                        const set<int> &classes,
@@ -1073,7 +1221,24 @@ public:
                        bool unrollLoops,
                        bool includeStageData,
                        bool forceSplitFee,
-                       bool useEventorQuirks);
+                       bool useEventorQuirks,
+                       IOFResultCache *resultCache = nullptr);
+
+  /** Export results to an opened output (file or memory). With a result cache (IOF 3.0 only),
+      runners unchanged since the last export with the same cache are not serialized again.*/
+  void exportIOFSplits(IOFVersion version, xmlparser &xml, bool oldStylePatrolExport,
+                       bool useUTC,
+                       const set<int> &classes,
+                       const tuple<string, string, bool> &preferredIdTypes,
+                       const wstring &cmpName,
+                       int leg,
+                       bool withPartialResult,
+                       bool teamsAsIndividual,
+                       bool unrollLoops,
+                       bool includeStageData,
+                       bool forceSplitFee,
+                       bool useEventorQuirks,
+                       IOFResultCache *resultCache = nullptr);
 
   void exportIOFStartlist(IOFVersion version, const wchar_t *file,
                           bool useUTC, const set<int> &classes,
@@ -1083,6 +1248,15 @@ public:
                           bool forceSplitFee,
                           bool useEventorQuirks);
 
+  /** Export a start list to an opened output (file or memory). */
+  void exportIOFStartlist(IOFVersion version, xmlparser &xml,
+                          bool useUTC, const set<int> &classes,
+                          const tuple<string, string, bool>& preferredIdTypes,
+                          bool teamsAsIndividual,
+                          bool includeStageInfo,
+                          bool forceSplitFee,
+                          bool useEventorQuirks);
+
   bool exportOECSV(const wchar_t *file, const set<int> &classes, int LanguageTypeIndex, bool includeSplits);
   bool save();
   void duplicate(const wstring &annotation, bool keepTags = false);
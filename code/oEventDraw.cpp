@@ -1837,7 +1837,7 @@ namespace {
     }
   }
 
-  void printGroups(gdioutput& gdibase, const list<oRunner>& Runners) {
+  void printGroups(gdioutput& gdibase, const oRunnerList& Runners) {
     map<int, vector<const oRunner*>> rbg;
     for (const oRunner& r : Runners) {
       rbg[r.getStartGroup(true)].push_back(&r);
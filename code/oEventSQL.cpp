@@ -138,7 +138,7 @@ bool oEvent::synchronizeList(initializer_list<oListId> types) {
     }
 
     if (t == oListId::oLPunchId)
-      advanceInformationPunches.clear();
+      clearAdvancePunchInformation();
   }
 
   reinitializeClasses();
@@ -176,7 +176,7 @@ bool oEvent::synchronizeList(oListId id, bool preSyncEvent, bool postSyncEvent)
   }
 
   if (id == oListId::oLPunchId)
-    advanceInformationPunches.clear();
+    clearAdvancePunchInformation();
 
   if (postSyncEvent) {
     reinitializeClasses();
@@ -225,6 +225,9 @@ void oEvent::resetSQLChanged(bool resetAllTeamsRunners, bool cleanClasses) {
   sqlCards.changed = false;
   sqlPunches.changed = false;
   sqlTeams.changed = false;
+  sqlChangedControls.clear();
+  sqlChangedCourses.clear();
+  sqlChangedClasses.clear();
 
   if (resetAllTeamsRunners) {
     for (auto &r : Runners) 
@@ -698,7 +701,7 @@ bool oEvent::reConnect(string &err)
     isConnectedToServer = true;
     hasPendingDBConnection = false;
     //synchronize changed objects
-    for (list<oCard>::iterator it=oe->Cards.begin();
+    for (oCardList::iterator it=oe->Cards.begin();
           it!=oe->Cards.end(); ++it)
       if (it->isChanged())
         it->synchronize(false);
@@ -723,17 +726,17 @@ bool oEvent::reConnect(string &err)
       if (it->isChanged())
         it->synchronize(false);
 
-    for (list<oRunner>::iterator it=oe->Runners.begin();
+    for (oRunnerList::iterator it=oe->Runners.begin();
         it!=oe->Runners.end(); ++it)
       if (it->isChanged())
         it->synchronize(false);
 
-    for (list<oTeam>::iterator it=oe->Teams.begin();
+    for (oTeamList::iterator it=oe->Teams.begin();
         it!=oe->Teams.end(); ++it)
       if (it->isChanged())
         it->synchronize(false);
 
-    for (list<oFreePunch>::iterator it=oe->punches.begin();
+    for (oFreePunchList::iterator it=oe->punches.begin();
         it!=oe->punches.end(); ++it)
       if (it->isChanged())
         it->synchronize(false);
@@ -754,7 +757,7 @@ int oEvent::checkChanged(vector<wstring> &out) const
   wchar_t bf[256];
   out.clear();
 
-  for (list<oCard>::iterator it=oe->Cards.begin();
+  for (oCardList::iterator it=oe->Cards.begin();
     it!=oe->Cards.end(); ++it)
     if (it->isChanged()) {
       changed++;
@@ -799,7 +802,7 @@ int oEvent::checkChanged(vector<wstring> &out) const
       it->synchronize();
     }
 
-  for (list<oRunner>::iterator it=oe->Runners.begin();
+  for (oRunnerList::iterator it=oe->Runners.begin();
       it!=oe->Runners.end(); ++it)
     if (it->isChanged()) {
       changed++;
@@ -807,7 +810,7 @@ int oEvent::checkChanged(vector<wstring> &out) const
       out.push_back(bf);
       it->synchronize();
     }
-  for (list<oTeam>::iterator it=oe->Teams.begin();
+  for (oTeamList::iterator it=oe->Teams.begin();
       it!=oe->Teams.end(); ++it)
     if (it->isChanged()) {
       changed++;
@@ -815,7 +818,7 @@ int oEvent::checkChanged(vector<wstring> &out) const
       out.push_back(bf);
       it->synchronize();
     }
-  for (list<oFreePunch>::iterator it=oe->punches.begin();
+  for (oFreePunchList::iterator it=oe->punches.begin();
       it!=oe->punches.end(); ++it)
     if (it->isChanged()) {
       changed++;
@@ -25,6 +25,7 @@
 #include <vector>
 #include <io.h>
 #include <algorithm>
+#include <chrono>
 
 #include "oEvent.h"
 #include "oSpeaker.h"
@@ -1639,6 +1640,19 @@ void insertResult(TempResultMap &rm, oRunner &r, int time,
   }
 }
 
+TimeLineIterator oEvent::insertTimeLineEvent(int time, const oTimeLine &tl) {
+  TimeLineIterator it = timeLineEvents.insert(pair<int, oTimeLine>(time, tl));
+  if (timeLineSetupClass)
+    timeLineSetupClass->events.push_back(it);
+  return it;
+}
+
+void oEvent::eraseTimeLineEvents(TimeLineClass &tlc) {
+  for (TimeLineIterator it : tlc.events)
+    timeLineEvents.erase(it);
+  tlc.events.clear();
+}
+
 int oEvent::setupTimeLineEvents(int currentTime)
 {
   if (currentTime == 0) {
@@ -1646,21 +1660,59 @@ int oEvent::setupTimeLineEvents(int currentTime)
     currentTime = getComputerTime();
   }
 
-  int nextKnownEvent = timeConstHour*48;
-  vector<pRunner> started;
-  started.reserve(Runners.size());
-  timeLineEvents.clear();
+  auto t0 = std::chrono::steady_clock::now();
 
-  for(set<int>::iterator it = timelineClasses.begin(); it != timelineClasses.end(); ++it) {
-    int ne = setupTimeLineEvents(*it, currentTime);
-    nextKnownEvent = min(ne, nextKnownEvent);
-    modifiedClasses.erase(*it);
+  // Only classes that changed or have a passed event are recomputed
+  map<int, vector<pRunner>> classRunners;
+  for (auto &tc : timelineClasses) {
+    if (modifiedClasses.count(tc.first) || tc.second.nextEvent <= currentTime)
+      classRunners[tc.first];
+  }
+
+  if (!classRunners.empty()) {
+    for (oRunner &r : Runners) {
+      if (r.isRemoved() || r.isVacant() || !r.Class)
+        continue;
+      auto res = classRunners.find(r.Class->Id);
+      if (res != classRunners.end())
+        res->second.push_back(&r);
+    }
   }
+
+  for (auto &cr : classRunners) {
+    TimeLineClass &tlc = timelineClasses[cr.first];
+    eraseTimeLineEvents(tlc);
+    timeLineSetupClass = &tlc;
+    try {
+      tlc.nextEvent = setupTimeLineEvents(cr.first, cr.second, currentTime);
+    }
+    catch (...) {
+      timeLineSetupClass = nullptr;
+      throw;
+    }
+    timeLineSetupClass = nullptr;
+    modifiedClasses.erase(cr.first);
+  }
+
+  int nextKnownEvent = timeConstHour*48;
+  for (auto &tc : timelineClasses)
+    nextKnownEvent = min(tc.second.nextEvent, nextKnownEvent);
+
+  int refreshTime = int(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count());
+  timeLineMaxRefreshTime = max(timeLineMaxRefreshTime, refreshTime);
+#ifdef _DEBUG
+  const int refreshBudget = 100000;
+  string info = "SetupTimeLine: " + itos(classRunners.size()) + " of " + itos(timelineClasses.size()) +
+                " classes in " + itos(refreshTime) + " us (max " + itos(timeLineMaxRefreshTime) + " us)";
+  if (refreshTime > refreshBudget)
+    info += ", over budget";
+  OutputDebugStringA((info + "\n").c_str());
+#endif
   return nextKnownEvent;
 }
 
 
-int oEvent::setupTimeLineEvents(int classId, int currentTime)
+int oEvent::setupTimeLineEvents(int classId, const vector<pRunner> &classRunners, int currentTime)
 {
   // leg -> started on leg
   vector< vector<pRunner> > started;
@@ -1699,12 +1751,8 @@ int oEvent::setupTimeLineEvents(int classId, int currentTime)
   // Count the number of starters at the same time
   inthashmap startTimes;
 
-  for (oRunnerList::iterator it = Runners.begin(); it != Runners.end(); ++it) {
-    oRunner &r = *it;
-    if (r.isRemoved() || r.isVacant())
-      continue;
-    if (!r.Class ||r.Class->Id != classId)
-      continue;
+  for (pRunner pr : classRunners) {
+    oRunner &r = *pr;
     if (r.tStatus == StatusDNS || r.tStatus == StatusCANCEL || r.tStatus == StatusNotCompeting)
       continue;
 //    if (r.CardNo == 0)
@@ -1716,7 +1764,7 @@ int oEvent::setupTimeLineEvents(int classId, int currentTime)
     if (r.tStartTime > 0 && r.tStartTime <= currentTime) {
       if (started.size() <= size_t(r.tLeg)) {
         started.resize(r.tLeg+1);
-        started.reserve(Runners.size() / (r.tLeg + 1));
+        started.reserve(classRunners.size() / (r.tLeg + 1));
       }
       r.tTimeAfter = 0; //Reset time after
       r.tInitialTimeAfter = 0;
@@ -1742,7 +1790,7 @@ int oEvent::setupTimeLineEvents(int classId, int currentTime)
     oRunner &r = *started[firstNonEmpty][0];
 
     oTimeLine tl(r.tStartTime, oTimeLine::TLTStart, oTimeLine::PHigh, r.getClassId(true), 0, 0);
-    TimeLineIterator it = timeLineEvents.insert(pair<int, oTimeLine>(r.tStartTime, tl));
+    TimeLineIterator it = insertTimeLineEvent(r.tStartTime, tl);
     it->second.setMessage(L"X har startat.#" + r.getClass(true));
   }
   else {
@@ -1759,13 +1807,13 @@ int oEvent::setupTimeLineEvents(int classId, int currentTime)
           else if (p == 1)
             prio = oTimeLine::PMedium;
           oTimeLine tl(r.tStartTime, oTimeLine::TLTStart, prio, r.getClassId(true), r.getId(), &r);
-          TimeLineIterator it = timeLineEvents.insert(pair<int, oTimeLine>(r.tStartTime + 1, tl));
+          TimeLineIterator it = insertTimeLineEvent(r.tStartTime + 1, tl);
           it->second.setMessage(L"har startat.");
         }
         else if (!startedClass) {
           // The entire class started
           oTimeLine tl(r.tStartTime, oTimeLine::TLTStart, oTimeLine::PHigh, r.getClassId(true), 0, 0);
-          TimeLineIterator it = timeLineEvents.insert(pair<int, oTimeLine>(r.tStartTime, tl));
+          TimeLineIterator it = insertTimeLineEvent(r.tStartTime, tl);
           it->second.setMessage(L"X har startat.#" + r.getClass(true));
           startedClass = true;
         }
@@ -1856,7 +1904,7 @@ void oEvent::timeLinePrognose(TempResultMap &results, TimeRunner &tr, int prelT,
       mp = oTimeLine::PLow;
 
     oTimeLine tl(tr.time, oTimeLine::TLTExpected, mp, tr.runner->getClassId(true), radioId, tr.runner);
-    TimeLineIterator tlit = timeLineEvents.insert(pair<int, oTimeLine>(tl.getTime(), tl));
+    TimeLineIterator tlit = insertTimeLineEvent(tl.getTime(), tl);
     tlit->second.setMessage(msg);
   }
 }
@@ -1951,6 +1999,9 @@ int oEvent::setupTimeLineEvents(vector<pRunner> &started, const vector< pair<int
       if ( (actual == 0 && (expected - pwTime) < currentTime) || (actual > (expected - pwTime)) ) {
         expectedRadio.push_back(TimeRunner(expected-pwTime, &r));
       }
+      else if (actual == 0) {
+        nextKnownEvent = min(nextKnownEvent, expected - pwTime);
+      }
     }
   }
 
@@ -2064,7 +2115,7 @@ int oEvent::setupTimeLineEvents(vector<pRunner> &started, const vector< pair<int
           mp = oTimeLine::PMedium;
 
         oTimeLine tl(radio[k].time, oTimeLine::TLTRadio, mp, r.getClassId(true),  rc[j].first, &r);
-        TimeLineIterator tlit = timeLineEvents.insert(pair<int, oTimeLine>(tl.getTime(), tl));
+        TimeLineIterator tlit = insertTimeLineEvent(tl.getTime(), tl);
         tlit->second.setMessage(msg).setDetail(detail);
       }
     }
@@ -2162,7 +2213,7 @@ int oEvent::setupTimeLineEvents(vector<pRunner> &started, const vector< pair<int
         mp = oTimeLine::PMedium;
 
       oTimeLine tl(r.FinishTime, oTimeLine::TLTFinish, mp, r.getClassId(true), r.getId(), &r);
-      TimeLineIterator tlit = timeLineEvents.insert(pair<int, oTimeLine>(tl.getTime(), tl));
+      TimeLineIterator tlit = insertTimeLineEvent(tl.getTime(), tl);
       tlit->second.setMessage(msg).setDetail(detail);
     }
     else if (r.getStatus() != StatusUnknown && r.getStatus() != StatusOK) {
@@ -2188,7 +2239,7 @@ int oEvent::setupTimeLineEvents(vector<pRunner> &started, const vector< pair<int
         mp = oTimeLine::PMedium;
 
       oTimeLine tl(r.FinishTime, oTimeLine::TLTFinish, mp, r.getClassId(true), r.getId(), &r);
-      TimeLineIterator tlit = timeLineEvents.insert(pair<int, oTimeLine>(t, tl));
+      TimeLineIterator tlit = insertTimeLineEvent(t, tl);
       wstring msg;
       if (r.getStatus() != StatusDQ)
         msg = L"är inte godkänd.";
@@ -2236,15 +2287,12 @@ int oEvent::getTimeLineEvents(const set<int> &classes, vector<oTimeLine> &events
   const int timeWindowSize = 10*60;
   int eval = nextTimeLineEvent <= getComputerTime() + 1;
   for (set<int>::const_iterator it = classes.begin(); it != classes.end(); ++it) {
-    if (timelineClasses.count(*it) == 0) {
-      timelineClasses.insert(*it);
+    if (timelineClasses.emplace(*it, TimeLineClass()).second)
       eval = true;
-    }
     if (modifiedClasses.count(*it) != 0)
       eval = true;
   }
   if (eval) {
-    OutputDebugStringA("SetupTimeLine\n");
     nextTimeLineEvent = setupTimeLineEvents(currentTime);
   }
 //  else
@@ -2287,9 +2335,10 @@ int oEvent::getTimeLineEvents(const set<int> &classes, vector<oTimeLine> &events
 }
 
 void oEvent::classChanged(pClass cls, bool punchOnly) {
-  if (timelineClasses.count(cls->getId()) == 1) {
+  auto res = timelineClasses.find(cls->getId());
+  if (res != timelineClasses.end()) {
     modifiedClasses.insert(cls->getId());
-    timeLineEvents.clear();
+    eraseTimeLineEvents(res->second);
   }
 }
 
@@ -2328,74 +2377,101 @@ struct TeamLegControl {
   }
 };
 
-void oEvent::getResultEvents(const set<int> &classFilter, const set<int> &punchFilter, vector<ResultEvent> &results) const {
-  results.clear();
-
-  vector<RunnerStatus> teamLegStatusOK;
-  teamLegStatusOK.reserve(Teams.size() * 5);
-  map<int, int> teamStatusPos;
-  for (oTeamList::const_iterator it = Teams.begin(); it != Teams.end(); ++it) {
-    if (!classFilter.count(it->getClassId(false)))
-      continue;
-
-    int base = teamLegStatusOK.size();
-    teamStatusPos[it->getId()] = base;
-    int nr = it->getNumRunners();
-    bool ok = it->getStatus() == StatusOK || it->getStatus() == StatusUnknown;
+namespace {
+  /** Status of the team after each leg, for result events of following legs.*/
+  void getTeamLegStatus(const oTeam &t, vector<RunnerStatus> &legStatus) {
+    int base = legStatus.size();
+    int nr = t.getNumRunners();
+    bool ok = t.getStatus() == StatusOK || t.getStatus() == StatusUnknown;
     for(int k = 0; k < nr; k++) {
-      pRunner r = it->getRunner(k);
+      pRunner r = t.getRunner(k);
       if (r && r->getStatus() != StatusUnknown && r->getStatus() != StatusOK)
         ok = false;
 
-      teamLegStatusOK.push_back(ok ? StatusOK : StatusUnknown);
+      legStatus.push_back(ok ? StatusOK : StatusUnknown);
     }
     if (!ok) { // A more careful analysis
       for(int k = 0; k < nr; k++) {
-        teamLegStatusOK[base + k] = it->getLegStatus(k, true, true);
+        legStatus[base + k] = t.getLegStatus(k, true, true);
       }
     }
   }
+}
 
-  for (oRunnerList::const_iterator it = Runners.begin(); it != Runners.end(); ++it) {
-    const oRunner &r = *it;
-    if (r.isRemoved() || !classFilter.count(r.getClassId(true)))
-      continue;
+void oEvent::addRunnerResultEvents(const oRunner &r, RunnerStatus prevLegStatus,
+                                   const set<int> &punchFilter, vector<ResultEvent> &results) const {
+  if (r.getStatusComputed(true) == StatusOutOfCompetition || r.getStatusComputed(true) == StatusNoTiming)
+    return;
 
-    if (r.getStatusComputed(true) == StatusOutOfCompetition || r.getStatusComputed(true) == StatusNoTiming)
-      continue;
+  bool wroteResult = false;
+  if (r.prelStatusOK(true, false, true) || r.getStatusComputed(true) != StatusUnknown) {
+    RunnerStatus stat = r.prelStatusOK(true, false, true) ? StatusOK : r.getStatusComputed(true);
+    wroteResult = true;
+    results.push_back(ResultEvent(pRunner(&r), r.getFinishTime(), oPunch::PunchFinish, stat));
+  }
+  pCard card = r.getCard();
+
+  RunnerStatus punchStatus = StatusOK;
+  if (prevLegStatus != StatusOK && prevLegStatus != StatusUnknown) {
+    if (wroteResult)
+      results.back().status = StatusNotCompeting;
+    punchStatus = StatusNotCompeting;
+  }
 
-    bool wroteResult = false;
-    if (r.prelStatusOK(true, false, true) || r.getStatusComputed(true) != StatusUnknown) {
-      RunnerStatus stat = r.prelStatusOK(true, false, true) ? StatusOK : r.getStatusComputed(true);
-      wroteResult = true;
-      results.push_back(ResultEvent(pRunner(&r), r.getFinishTime(), oPunch::PunchFinish, stat));
+  if (card) {
+    oPunchList::const_iterator it;
+    map<int,int> dupCount;
+    for (it = card->punches.begin(); it != card->punches.end(); ++it) {
+      if  (punchFilter.count(it->tMatchControlId)) {
+        int dupC = ++dupCount[it->tMatchControlId];
+        int courseControlId = oControl::getCourseControlIdFromIdIndex(it->tMatchControlId, dupC-1);
+        results.push_back(ResultEvent(pRunner(&r), it->getAdjustedTime(), courseControlId, punchStatus));
+      }
     }
-    pCard card = r.getCard();
-    
-    RunnerStatus punchStatus = StatusOK;
+  }
+}
+
+void oEvent::addPunchResultEvent(const oFreePunch &fp, const oRunner &r, RunnerStatus prevLegStatus,
+                                 const set<int> &punchFilter, vector<ResultEvent> &results) const {
+  int courseControlId = oFreePunch::getControlIdFromHash(fp.iHashType, true);
+  int ctrl = oControl::getIdIndexFromCourseControlId(courseControlId).first;
+  if (!punchFilter.count(ctrl))
+    return;
+
+  results.push_back(ResultEvent(pRunner(&r), fp.getTimeInt(), courseControlId, StatusOK));
+  if (prevLegStatus != StatusOK && prevLegStatus != StatusUnknown)
+    results.back().status = StatusNotCompeting;
+}
+
+void oEvent::getResultEvents(const set<int> &classFilter, const set<int> &punchFilter, vector<ResultEvent> &results) const {
+  results.clear();
+
+  vector<RunnerStatus> teamLegStatusOK;
+  teamLegStatusOK.reserve(Teams.size() * 5);
+  map<int, int> teamStatusPos;
+  for (oTeamList::const_iterator it = Teams.begin(); it != Teams.end(); ++it) {
+    if (!classFilter.count(it->getClassId(false)))
+      continue;
+
+    teamStatusPos[it->getId()] = teamLegStatusOK.size();
+    getTeamLegStatus(*it, teamLegStatusOK);
+  }
+
+  auto prevLegStatus = [&teamLegStatusOK, &teamStatusPos](const oRunner &r) {
     if (r.tInTeam && r.tLeg > 0) {
       map<int, int>::iterator res = teamStatusPos.find(r.tInTeam->getId());
-      if (res != teamStatusPos.end()) {
-        RunnerStatus prevStat = teamLegStatusOK[res->second + r.tLeg - 1];
-        if (prevStat != StatusOK && prevStat != StatusUnknown) {
-          if (wroteResult)
-            results.back().status = StatusNotCompeting;
-          punchStatus = StatusNotCompeting;
-        }
-      }
+      if (res != teamStatusPos.end())
+        return teamLegStatusOK[res->second + r.tLeg - 1];
     }
+    return StatusOK;
+  };
 
-    if (card) {
-      oPunchList::const_iterator it;
-      map<int,int> dupCount;
-      for (it = card->punches.begin(); it != card->punches.end(); ++it) {
-        if  (punchFilter.count(it->tMatchControlId)) {
-          int dupC = ++dupCount[it->tMatchControlId];
-          int courseControlId = oControl::getCourseControlIdFromIdIndex(it->tMatchControlId, dupC-1);
-          results.push_back(ResultEvent(pRunner(&r), it->getAdjustedTime(), courseControlId, punchStatus));
-        }
-      }
-    }
+  for (oRunnerList::const_iterator it = Runners.begin(); it != Runners.end(); ++it) {
+    const oRunner &r = *it;
+    if (r.isRemoved() || !classFilter.count(r.getClassId(true)))
+      continue;
+
+    addRunnerResultEvents(r, prevLegStatus(r), punchFilter, results);
   }
 
   for (oFreePunchList::const_iterator it = punches.begin(); it != punches.end(); ++it) {
@@ -2407,23 +2483,7 @@ void oEvent::getResultEvents(const set<int> &classFilter, const set<int> &punchF
     if (r == 0 || !classFilter.count(r->getClassId(true)) || r->getCard())
       continue;
 
-    int courseControlId = oFreePunch::getControlIdFromHash(fp.iHashType, true);
-    int ctrl = oControl::getIdIndexFromCourseControlId(courseControlId).first;
-
-    if (!punchFilter.count(ctrl))
-      continue;
-
-    results.push_back(ResultEvent(r, fp.getTimeInt(), courseControlId, StatusOK));
-
-    if (r->tInTeam && r->tLeg > 0) {
-      map<int, int>::iterator res = teamStatusPos.find(r->tInTeam->getId());
-      if (res != teamStatusPos.end()) {
-        RunnerStatus prevStat = teamLegStatusOK[res->second + r->tLeg - 1];
-        if (prevStat != StatusOK && prevStat != StatusUnknown) {
-          results.back().status = StatusNotCompeting; 
-        }
-      }
-    }
+    addPunchResultEvent(fp, *r, prevLegStatus(*r), punchFilter, results);
   }
 
   for (map<pair<int,int>, oFreePunch>::const_iterator it = advanceInformationPunches.begin(); 
@@ -2434,22 +2494,8 @@ void oEvent::getResultEvents(const set<int> &classFilter, const set<int> &punchF
     pRunner r = getRunner(fp.tRunnerId, 0);
     if (r == 0 || !classFilter.count(r->getClassId(true)))
       continue;
-    int courseControlId = oFreePunch::getControlIdFromHash(fp.iHashType, true);
-    int ctrl = oControl::getIdIndexFromCourseControlId(courseControlId).first;
-    if (!punchFilter.count(ctrl))
-      continue;
-
-    results.push_back(ResultEvent(r, fp.getTimeInt(), courseControlId, StatusOK));
 
-    if (r->tInTeam && r->tLeg > 0) {
-      map<int, int>::iterator res = teamStatusPos.find(r->tInTeam->getId());
-      if (res != teamStatusPos.end()) {
-        RunnerStatus prevStat = teamLegStatusOK[res->second + r->tLeg - 1];
-        if (prevStat != StatusOK && prevStat != StatusUnknown) {
-          results.back().status = StatusNotCompeting; 
-        }
-      }
-    }
+    addPunchResultEvent(fp, *r, prevLegStatus(*r), punchFilter, results);
   }
 
   map< int, vector<LegSetupInfo> > parLegSetup;
@@ -2537,3 +2583,141 @@ void oEvent::getResultEvents(const set<int> &classFilter, const set<int> &punchF
     }
   }
 }
+
+void oEvent::getResultEvents(const set<int> &runnerIds, const set<int> &punchFilter, vector<ResultEvent> &results) const {
+  results.clear();
+  vector<RunnerStatus> teamLegStatus;
+  vector<pFreePunch> runnerPunches;
+  for (int id : runnerIds) {
+    pRunner r = getRunner(id, 0);
+    if (r == nullptr || r->isRemoved())
+      continue;
+
+    RunnerStatus prevLegStatus = StatusOK;
+    if (r->tInTeam && r->tLeg > 0) {
+      teamLegStatus.clear();
+      getTeamLegStatus(*r->tInTeam, teamLegStatus);
+      prevLegStatus = teamLegStatus[r->tLeg - 1];
+    }
+
+    addRunnerResultEvents(*r, prevLegStatus, punchFilter, results);
+
+    if (!r->getCard()) {
+      getPunchesForRunner(id, false, runnerPunches);
+      for (pFreePunch fp : runnerPunches) {
+        if (fp->type == oPunch::PunchCheck || fp->type == oPunch::PunchStart || fp->type == oPunch::HiredCard)
+          continue;
+        addPunchResultEvent(*fp, *r, prevLegStatus, punchFilter, results);
+      }
+    }
+
+    for (auto &it : advanceInformationPunches) {
+      const oFreePunch &fp = it.second;
+      if (fp.isRemoved() || fp.tRunnerId != id || fp.type == oPunch::PunchCheck || fp.type == oPunch::PunchStart)
+        continue;
+      addPunchResultEvent(fp, *r, prevLegStatus, punchFilter, results);
+    }
+  }
+}
+
+int oEvent::subscribeResultEvents(const set<int> &classFilter, int capacity) {
+  int id = ++resultEventFeedId;
+  ResultEventFeed &feed = resultEventFeeds[id];
+  feed.classFilter = classFilter;
+  feed.buffer.resize(max(capacity, 1));
+  return id;
+}
+
+void oEvent::unsubscribeResultEvents(int subscriptionId) {
+  resultEventFeeds.erase(subscriptionId);
+}
+
+void oEvent::pushResultEvent(const oRunner *r, int controlId, int time, long revisionBefore) {
+  for (auto &it : resultEventFeeds) {
+    ResultEventFeed &feed = it.second;
+    if (feed.lost)
+      continue; // Everything is reloaded anyway
+
+    bool match = r && (feed.classFilter.empty() || feed.classFilter.count(r->getClassId(true)));
+    if (!match && feed.count > 0) {
+      // Extend the revision range of a previous change outside the filter
+      ResultEventNotice &last = feed.buffer[(feed.first + feed.count - 1) % feed.buffer.size()];
+      if (last.runnerId == 0 && last.revisionAfter == revisionBefore) {
+        last.revisionAfter = dataRevision;
+        continue;
+      }
+    }
+
+    if (feed.count == feed.buffer.size()) {
+      feed.lost = true;
+      feed.first = 0;
+      feed.count = 0;
+      continue;
+    }
+
+    ResultEventNotice &n = feed.buffer[(feed.first + feed.count) % feed.buffer.size()];
+    feed.count++;
+    n.runnerId = match ? r->getId() : 0;
+    n.controlId = controlId;
+    n.time = time;
+    n.revisionBefore = revisionBefore;
+    n.revisionAfter = dataRevision;
+  }
+}
+
+bool oEvent::takeResultEventNotices(int subscriptionId, long &revision, vector<ResultEventNotice> &notices) {
+  notices.clear();
+  auto res = resultEventFeeds.find(subscriptionId);
+  if (res == resultEventFeeds.end())
+    return false;
+
+  ResultEventFeed &feed = res->second;
+  bool complete = !feed.lost;
+  long rev = revision;
+  for (size_t k = 0; k < feed.count; k++) {
+    const ResultEventNotice &n = feed.buffer[(feed.first + k) % feed.buffer.size()];
+    if (n.revisionBefore != rev)
+      complete = false;
+    rev = n.revisionAfter;
+    if (n.runnerId != 0)
+      notices.push_back(n);
+  }
+
+  if (rev != getRevision())
+    complete = false;
+
+  feed.first = 0;
+  feed.count = 0;
+  feed.lost = false;
+  revision = getRevision();
+  return complete;
+}
+
+bool oEvent::getResultEventRunners(const vector<ResultEventNotice> &notices, set<int> &runnerIds) const {
+  runnerIds.clear();
+  for (const ResultEventNotice &n : notices) {
+    pRunner r = getRunner(n.runnerId, 0);
+    if (r == nullptr)
+      return false;
+
+    pClass cls = r->getClassRef(true);
+    int ns = cls ? cls->getNumStages() : 0;
+    if (ns > 1) {
+      for (int k = 0; k < ns; k++) {
+        if (cls->legInfo[k].isOptional() || cls->legInfo[k].isParallel())
+          return false;
+      }
+    }
+
+    runnerIds.insert(n.runnerId);
+    // The status of following legs depends on this runner
+    if (r->tInTeam) {
+      for (int k = r->tLeg + 1; k < r->tInTeam->getNumRunners(); k++) {
+        pRunner tr = r->tInTeam->getRunner(k);
+        if (tr)
+          runnerIds.insert(tr->getId());
+      }
+    }
+  }
+  return true;
+}
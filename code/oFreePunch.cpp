@@ -32,6 +32,7 @@
 #include "socket.h"
 #include "gdioutput.h"
 #include "xmlparser.h"
+#include "intkeymapimpl.hpp"
 
 bool oFreePunch::disableHashing = false;
 
@@ -107,17 +108,8 @@ bool oFreePunch::setCardNo(int cno, bool databaseUpdate) {
   if (cno != CardNo) {
     pRunner r1 = oe->getRunner(tRunnerId, 0);
     int oldControlId = tMatchControlId;
-    //oe->punchIndex[itype].remove(CardNo); // Remove from index
     // Remove ourself from index
-    oEvent::PunchIndexType &pi = oe->punchIndex[iHashType];
-    oEvent::PunchConstIterator it = pi.find(CardNo);
-    while (it != pi.end() && it->first == CardNo) {
-      if (it->second == this) {
-        pi.erase(it);
-        break;
-      }
-      ++it;
-    }
+    oe->removeFromPunchIndex(this);
     oe->removeFromPunchHash(CardNo, type, punchTime);
     rehashPunches(*oe, CardNo, 0);
 
@@ -295,12 +287,20 @@ bool oFreePunch::setType(const wstring &t, bool databaseUpdate) {
 }
 
 void oFreePunch::rehashPunches(oEvent &oe, int cardNo, pFreePunch newPunch) {
+  if (newPunch)
+    rehashPunches(oe, cardNo, vector<pFreePunch>(1, newPunch));
+  else
+    rehashPunches(oe, cardNo, vector<pFreePunch>());
+}
+
+void oFreePunch::rehashPunches(oEvent &oe, int cardNo, const vector<pFreePunch> &newPunches) {
   if (disableHashing || (cardNo == 0 && !oe.punchIndex.empty()) || oe.punches.empty())
     return;
   vector<pFreePunch> fp;
 
   if (oe.punchIndex.empty()) {
-    // Rehash all punches. Ignore cardNo and newPunch (will be included automatically)
+    // Rehash all punches. Ignore cardNo and newPunches (will be included automatically)
+    oe.cardPunchIndex.clear();
     fp.reserve(oe.punches.size());
     for (oFreePunchList::iterator pit = oe.punches.begin(); pit != oe.punches.end(); ++pit) {
       if (pit->isRemoved() || pit->isHiredCard())
@@ -318,6 +318,7 @@ void oFreePunch::rehashPunches(oEvent &oe, int cardNo, pFreePunch newPunch) {
 
         oEvent::PunchIndexType &card2Punch = oe.punchIndex[punch->iHashType];
         card2Punch.insert(make_pair(punch->CardNo, punch));
+        oe.cardPunchIndex[punch->CardNo].push_back(punch);
       }
     }
     catch(...) {
@@ -328,36 +329,57 @@ void oFreePunch::rehashPunches(oEvent &oe, int cardNo, pFreePunch newPunch) {
     return;
   }
 
-  map<int, oEvent::PunchIndexType>::iterator it;
-  fp.reserve(oe.punchIndex.size() + 1);
-
-  // Get all punches for the specified card.
-  for(it = oe.punchIndex.begin(); it != oe.punchIndex.end(); ++it) {
-    pair<oEvent::PunchConstIterator, oEvent::PunchConstIterator> res = it->second.equal_range(cardNo);
-    oEvent::PunchConstIterator pIter = res.first;
-    while(pIter != res.second) {
-      pFreePunch punch = pIter->second;
+  // Get all punches for the specified card and remove them from the control index.
+  auto cardIt = oe.cardPunchIndex.find(cardNo);
+  if (cardIt != oe.cardPunchIndex.end()) {
+    fp.reserve(cardIt->second.size() + newPunches.size());
+    for (pFreePunch punch : cardIt->second) {
       assert(punch && punch->CardNo == cardNo);
-      if (!punch->isRemoved()) {
+      auto it = oe.punchIndex.find(punch->iHashType);
+      if (it != oe.punchIndex.end())
+        it->second.erase(cardNo);
+      if (!punch->isRemoved())
         fp.push_back(punch);
-      }
-      ++pIter;
     }
-    it->second.erase(res.first, res.second);
+    oe.cardPunchIndex.erase(cardIt);
   }
 
-  if (newPunch && !newPunch->isHiredCard())
-    fp.push_back(newPunch);
+  for (pFreePunch newPunch : newPunches) {
+    if (!newPunch->isHiredCard())
+      fp.push_back(newPunch);
+  }
 
   sort(fp.begin(), fp.end(), FreePunchComp());
+  fp.erase(unique(fp.begin(), fp.end()), fp.end()); //Skip duplicates
   for (size_t j = 0; j < fp.size(); j++) {
-    if (j>0 && fp[j-1] == fp[j])
-      continue; //Skip duplicates
     pFreePunch punch = fp[j];
     punch->iHashType = oe.getControlIdFromPunch(punch->getTimeInt(), punch->type, cardNo, true, *punch);
     oEvent::PunchIndexType &card2Punch = oe.punchIndex[punch->iHashType];
     card2Punch.insert(make_pair(punch->CardNo, punch));
   }
+  if (!fp.empty())
+    oe.cardPunchIndex[cardNo].swap(fp);
+}
+
+void oEvent::removeFromPunchIndex(pFreePunch punch) {
+  auto it = punchIndex.find(punch->iHashType);
+  if (it != punchIndex.end()) {
+    pair<PunchIterator, PunchIterator> res = it->second.equal_range(punch->CardNo);
+    for (PunchIterator pIter = res.first; pIter != res.second; ++pIter) {
+      if (pIter->second == punch) {
+        it->second.erase(pIter);
+        break;
+      }
+    }
+  }
+
+  auto cardIt = cardPunchIndex.find(punch->CardNo);
+  if (cardIt != cardPunchIndex.end()) {
+    vector<pFreePunch> &cp = cardIt->second;
+    cp.erase(remove(cp.begin(), cp.end(), punch), cp.end());
+    if (cp.empty())
+      cardPunchIndex.erase(cardIt);
+  }
 }
 
 //const int legHashConstant = 100000;
@@ -432,31 +454,117 @@ void oEvent::getFreeControls(set<int> &controlId) const
   }
 }
 
-//set< pair<int,int> > readPunchHash;
-
 void oEvent::insertIntoPunchHash(int card, int code, int time) {
   if (time > 0) {
-    int p1 = time * 4096 + code;
-    int p2 = card;
-    readPunchHash.insert(make_pair(p1, p2));
+    __int64 key = getPunchHashKey(card, time);
+    int oldCode;
+    if (!readPunchHash.lookup(key, oldCode))
+      readPunchHash.insert(key, code);
+    else if (oldCode != code)
+      readPunchHashExtra.emplace(key, code);
   }
 }
 
 void oEvent::removeFromPunchHash(int card, int code, int time) {
-  int p1 = time * 4096 + code;
-  int p2 = card;
-  readPunchHash.erase(make_pair(p1, p2));
+  if (time <= 0)
+    return;
+  __int64 key = getPunchHashKey(card, time);
+  int oldCode;
+  if (readPunchHash.lookup(key, oldCode) && oldCode == code) {
+    readPunchHash.remove(key);
+    // Move a punch with the same key from the extra set
+    auto extra = readPunchHashExtra.lower_bound(make_pair(key, INT_MIN));
+    if (extra != readPunchHashExtra.end() && extra->first == key) {
+      readPunchHash.insert(key, extra->second);
+      readPunchHashExtra.erase(extra);
+    }
+  }
+  else if (!readPunchHashExtra.empty()) {
+    readPunchHashExtra.erase(make_pair(key, code));
+  }
 }
 
 bool oEvent::isInPunchHash(int card, int code, int time) {
-  int p1 = time * 4096 + code;
-  int p2 = card;
-  return readPunchHash.count(make_pair(p1, p2)) > 0;
+  if (time <= 0)
+    return false;
+  __int64 key = getPunchHashKey(card, time);
+  int oldCode;
+  if (!readPunchHash.lookup(key, oldCode))
+    return false;
+  return oldCode == code || (!readPunchHashExtra.empty() && readPunchHashExtra.count(make_pair(key, code)) > 0);
 }
 
 pFreePunch oEvent::addFreePunch(int time, int type, int unit, int card, bool updateStartFinish, bool isOriginal) {
   if (time > 0 && isInPunchHash(card, type, time))
     return 0;
+  long revision = dataRevision;
+  pFreePunch fp = createFreePunch(time, type, unit, card, isOriginal);
+  oFreePunch::rehashPunches(*this, card, fp);
+  insertIntoPunchHash(card, type, time);
+
+  processFreePunch(fp, updateStartFinish);
+  pRunner tr = fp->getTiedRunner();
+  if (tr != nullptr)
+    pushDirectChange();
+
+  pushResultEvent(tr, fp->getControlId(), fp->getAdjustedTime(), revision);
+  return fp;
+}
+
+int oEvent::addFreePunches(const vector<FreePunchInput> &input, bool updateStartFinish) {
+#ifdef _DEBUG
+  uint64_t t0 = GetTickCount64();
+#endif
+  long revision = dataRevision;
+  bool rehashAll = punchIndex.empty();
+  map<int, vector<pFreePunch>> cardPunches;
+  vector<pFreePunch> added;
+  added.reserve(input.size());
+
+  for (const FreePunchInput &in : input) {
+    // Skips punches already added, also within the batch
+    if (in.time > 0 && isInPunchHash(in.card, in.type, in.time))
+      continue;
+    pFreePunch fp = createFreePunch(in.time, in.type, in.unit, in.card, in.isOriginal);
+    insertIntoPunchHash(in.card, in.type, in.time);
+    cardPunches[in.card].push_back(fp);
+    added.push_back(fp);
+  }
+
+  if (added.empty())
+    return 0;
+
+  if (rehashAll)
+    oFreePunch::rehashPunches(*this, 0, nullptr);
+  else {
+    for (auto &cp : cardPunches)
+      oFreePunch::rehashPunches(*this, cp.first, cp.second);
+  }
+
+  bool anyRunner = false;
+  for (pFreePunch fp : added) {
+    processFreePunch(fp, updateStartFinish);
+    if (fp->getTiedRunner())
+      anyRunner = true;
+  }
+
+  if (anyRunner)
+    pushDirectChange();
+
+  for (pFreePunch fp : added) {
+    pushResultEvent(fp->getTiedRunner(), fp->getControlId(), fp->getAdjustedTime(), revision);
+    revision = dataRevision;
+  }
+
+#ifdef _DEBUG
+  uint64_t t = max<uint64_t>(GetTickCount64() - t0, 1);
+  string info = "Added " + itos(added.size()) + " punches (" + itos(int((1000 * added.size()) / t)) + " punches/s)\n";
+  OutputDebugStringA(info.c_str());
+#endif
+  return int(added.size());
+}
+
+pFreePunch oEvent::createFreePunch(int time, int type, int unit, int card, bool isOriginal) {
   oFreePunch ofp(this, card, time, type, unit);
   if (isOriginal)
     ofp.origin = ofp.computeOrigin(time, type);
@@ -464,9 +572,15 @@ pFreePunch oEvent::addFreePunch(int time, int type, int unit, int card, bool upd
   punches.emplace_back(ofp);
   pFreePunch fp=&punches.back();
   fp->addToEvent(this, &ofp);
-  oFreePunch::rehashPunches(*this, card, fp);
-  insertIntoPunchHash(card, type, time);
+  punchById[fp->Id] = fp;
+  addToPunchLog(*fp);
+  return fp;
+}
 
+void oEvent::processFreePunch(pFreePunch fp, bool updateStartFinish) {
+  int time = fp->punchTime;
+  int type = fp->type;
+  int unit = fp->punchUnit;
   if (fp->getTiedRunner() && oe->isClient() && oe->getPropertyInt("UseDirectSocket", true)!=0) {
     SocketPunchInfo pi;
     pi.runnerId = fp->getTiedRunner()->getId();
@@ -526,23 +640,24 @@ pFreePunch oEvent::addFreePunch(int time, int type, int unit, int card, bool upd
         }
       }
     }
-
-    pushDirectChange();
   }
-  return fp;
 }
 
 pFreePunch oEvent::addFreePunch(oFreePunch &fp) {
+  long revision = dataRevision;
   insertIntoPunchHash(fp.CardNo, fp.type, fp.punchTime);
   punches.push_back(fp);
   pFreePunch fpz=&punches.back();
   fpz->addToEvent(this, &fp);
+  punchById[fpz->Id] = fpz;
+  addToPunchLog(*fpz);
   oFreePunch::rehashPunches(*this, fp.CardNo, fpz);
 
   if (!fpz->existInDB() && hasDBConnection()) {
     fpz->changed = true;
     fpz->synchronize();
   }
+  pushResultEvent(fpz->getTiedRunner(), fpz->getControlId(), fpz->getAdjustedTime(), revision);
   return fpz;
 }
 
@@ -559,18 +674,9 @@ void oEvent::removeFreePunch(int Id) {
       pFreePunch fp = &*it;
       if (hasDBConnection())
         sqlRemove(fp);
-      //punchIndex[it->itype].remove(it->CardNo);
-      PunchIndexType &ix = punchIndex[it->iHashType];
-      pair<PunchConstIterator, PunchConstIterator> res = ix.equal_range(it->CardNo);
-      while (res.first != res.second) {
-        if (res.first->second == fp) {
-          PunchConstIterator rm = res.first;
-          ++res.first;
-          ix.erase(rm);
-        }
-        else
-          ++res.first;
-      }
+      removeFromPunchIndex(fp);
+      punchById.remove(Id);
+      removeFromPunchLog(*fp);
 
       int cardNo = fp->CardNo;
       removeFromPunchHash(cardNo, fp->type, fp->punchTime);
@@ -584,16 +690,10 @@ void oEvent::removeFreePunch(int Id) {
 
 pFreePunch oEvent::getPunch(int Id) const
 {
-  oFreePunchList::const_iterator it;
-
-  for (it=punches.begin(); it != punches.end(); ++it) {
-    if (it->Id==Id) {
-      if (it->isRemoved())
-        return 0;
-      return const_cast<pFreePunch>(&*it);
-    }
-  }
-  return 0;
+  pFreePunch p = punchById[Id];
+  if (p == 0 || p->Id != Id || p->isRemoved())
+    return 0;
+  return p;
 }
 
 pFreePunch oEvent::getPunch(int runnerId, int courseControlId, int card) const
@@ -655,22 +755,20 @@ void oEvent::getPunchesForRunner(int runnerId, bool doSort, vector<pFreePunch> &
   if (card == 0)
     return;
 
-  for (auto &it1 :punchIndex) {
-    const oEvent::PunchIndexType &cIndex = it1.second;
-    pair<oEvent::PunchConstIterator, oEvent::PunchConstIterator> res = cIndex.equal_range(card);
-    oEvent::PunchConstIterator pIter = res.first;
-    while (pIter != res.second) {
-      pFreePunch punch = pIter->second;
-      if (!punch->isRemoved()) {
-        assert(punch && punch->CardNo == card);
-        if (punch->tRunnerId == runnerId || runnerId == 0)
-          runnerPunches.push_back(punch);
-      }
-      ++pIter;
+  auto cardIt = cardPunchIndex.find(card);
+  if (cardIt == cardPunchIndex.end())
+    return;
+
+  // Sorted by time when the card was last hashed
+  for (pFreePunch punch : cardIt->second) {
+    if (!punch->isRemoved()) {
+      assert(punch && punch->CardNo == card);
+      if (punch->tRunnerId == runnerId || runnerId == 0)
+        runnerPunches.push_back(punch);
     }
   }
   
-  if (doSort) {
+  if (doSort && !is_sorted(runnerPunches.begin(), runnerPunches.end(), oFreePunch::FreePunchComp())) {
     sort(runnerPunches.begin(), runnerPunches.end(), [](const oPunch *p1, const oPunch *p2)->bool {return p1->getTimeInt() < p2->getTimeInt(); });
   }
 }
@@ -695,6 +793,7 @@ bool oEvent::advancePunchInformation(const vector<gdioutput *> &gdi, vector<Sock
           r->markClassChanged(oPunch::PunchFinish);
           classChanged(r->Class, false);
         }
+        pushResultEvent(r, oPunch::PunchFinish, r->FinishTime, dataRevision);
         m = true;
       }
     }
@@ -708,17 +807,21 @@ bool oEvent::advancePunchInformation(const vector<gdioutput *> &gdi, vector<Sock
         fp.tMatchControlId = oFreePunch::getControlIdFromHash(fp.iHashType, false);
         fp.changed = false;
         pair<int, int> hc(pi[k].iHashType, r->getCardNo());
-        advanceInformationPunches.insert(make_pair(hc, fp));
+        auto res = advanceInformationPunches.insert(make_pair(hc, fp));
+        if (res.second)
+          addToPunchLog(res.first->second);
         if (r->Class) {
           r->markClassChanged(oFreePunch::getControlIdFromHash(pi[k].iHashType, false));
           classChanged(r->Class, true);
         }
+        pushResultEvent(r, fp.tMatchControlId, fp.getTimeInt(), dataRevision);
         m = true;
       }
     }
   }
   if (m) {
     dataRevision++;
+    pushResultEvent(nullptr, 0, 0, dataRevision - 1);
     for (size_t k = 0; k<gdi.size(); k++) {
       if (gdi[k])
         gdi[k]->makeEvent("DataUpdate", "autosync", 0, 0, false);
@@ -727,19 +830,69 @@ bool oEvent::advancePunchInformation(const vector<gdioutput *> &gdi, vector<Sock
   return m;
 }
 
+void oEvent::clearAdvancePunchInformation() {
+  for (auto &it : advanceInformationPunches)
+    removeFromPunchLog(it.second);
+  advanceInformationPunches.clear();
+}
+
 void oEvent::getLatestPunches(int firstTime, vector<const oFreePunch *> &punchesOut) const {
-  for (map< pair<int, int>, oFreePunch>::const_iterator it = advanceInformationPunches.begin();
-       it != advanceInformationPunches.end(); ++it) {
-    int time = it->second.getModificationTime();
-    if (time >= firstTime)
-      punchesOut.push_back(&it->second);
+  auto it = lower_bound(punchLog.begin(), punchLog.end(), firstTime,
+                        [](const PunchLogEntry &e, int time) {return int(e.time) < time; });
+
+  for (; it != punchLog.end(); ++it) {
+    if (it->punch && int(it->punch->getModificationTime()) >= firstTime)
+      punchesOut.push_back(it->punch);
   }
+}
+
+void oEvent::getChangedPunches(int &cursor, vector<const oFreePunch *> &punchesOut) const {
+  auto it = lower_bound(punchLog.begin(), punchLog.end(), cursor,
+                        [](const PunchLogEntry &e, int serial) {return e.serial < serial; });
 
-  for (oFreePunchList::const_iterator it = punches.begin(); it != punches.end(); ++it) {
-    int time = it->getModificationTime();
-    if (time >= firstTime)
-      punchesOut.push_back(&*it);
+  for (; it != punchLog.end(); ++it) {
+    if (it->punch)
+      punchesOut.push_back(it->punch);
   }
+  cursor = punchLogSerial;
+}
+
+void oEvent::addToPunchLog(oFreePunch &punch) {
+  removeFromPunchLog(punch);
+  unsigned int time = punch.getModificationTime();
+  if (!punchLog.empty())
+    time = max(time, punchLog.back().time);
+
+  punch.tPunchLog = punchLog.size();
+  punchLog.push_back({ time, punchLogSerial++, &punch });
+}
+
+void oEvent::removeFromPunchLog(oFreePunch &punch) {
+  int ix = punch.tPunchLog;
+  // The index is copied with the punch, check that the entry is ours
+  if (ix >= 0 && size_t(ix) < punchLog.size() && punchLog[ix].punch == &punch) {
+    punchLog[ix].punch = nullptr;
+    punchLogUnused++;
+  }
+  punch.tPunchLog = -1;
+
+  if (punchLogUnused > 1024 && punchLogUnused * 2 > int(punchLog.size())) {
+    // Compact the log. Order and serial numbers are kept.
+    size_t out = 0;
+    for (size_t k = 0; k < punchLog.size(); k++) {
+      if (punchLog[k].punch) {
+        punchLog[k].punch->tPunchLog = out;
+        punchLog[out++] = punchLog[k];
+      }
+    }
+    punchLog.resize(out);
+    punchLogUnused = 0;
+  }
+}
+
+void oEvent::clearPunchLog() {
+  punchLog.clear();
+  punchLogUnused = 0;
 }
 
 pRunner oFreePunch::getTiedRunner() const {
@@ -751,6 +904,19 @@ void oFreePunch::changedObject() {
   if (r && tMatchControlId>0)
     r->markClassChanged(tMatchControlId);
   oe->sqlPunches.changed = true;
+  if (isAddedToEvent())
+    oe->addToPunchLog(*this);
+}
+
+void oFreePunch::changeId(int newId) {
+  pFreePunch *old = isAddedToEvent() ? oe->punchById.find(Id) : nullptr;
+  if (old && *old == this)
+    oe->punchById.remove(Id);
+
+  oBase::changeId(newId);
+
+  if (isAddedToEvent())
+    oe->punchById[newId] = this;
 }
 
 bool oEvent::hasHiredCardData() {
@@ -790,6 +956,8 @@ void oEvent::setHiredCard(int cardNo, bool flag) {
 
           auto toErase = it;
           ++it;
+          punchById.remove(toErase->Id);
+          removeFromPunchLog(*toErase);
           punches.erase(toErase);
         }
         else {
@@ -816,6 +984,8 @@ void oEvent::clearHiredCards() {
 
       auto toErase = it;
       ++it;
+      punchById.remove(toErase->Id);
+      removeFromPunchLog(*toErase);
       punches.erase(toErase);
     }
     else {
@@ -38,6 +38,7 @@ protected:
   int CardNo;
   int iHashType; //Index type used for lookup
   int tRunnerId; // Id of runner the punch is classified to.
+  int tPunchLog = -1; // Index in oEvent::punchLog
 
   /** Class used to sort punches by time. */
   class FreePunchComp {
@@ -48,6 +49,7 @@ protected:
   };
 
   void changedObject();
+  void changeId(int newId) override;
 
 public:
 
@@ -84,6 +86,7 @@ public:
   void setTimeInt(int newTime, bool databaseUpdate) final;
 
   static void rehashPunches(oEvent &oe, int cardNo, pFreePunch newPunch);
+  static void rehashPunches(oEvent &oe, int cardNo, const vector<pFreePunch> &newPunches);
   static bool disableHashing;
 
   void merge(const oBase &input, const oBase *base) final;
@@ -1298,7 +1298,13 @@ void oEvent::importXML_IOF_Data(const wstring &clubfile,
     gdibase.addString("",0,"Läser löpare...");
     gdibase.refresh();
 
-    xml_cmp.read(competitorfile);
+    // Peek at the root element. IOF 3.0 competitor lists are streamed,
+    // other formats are read into memory.
+    xml_cmp.read(competitorfile, 8);
+    xmlobject xo = xml_cmp.getObject("CompetitorList");
+    const bool streamIOF = xo && xo.getAttrib("iofVersion");
+    if (!streamIOF)
+      xml_cmp.read(competitorfile);
 
     if (clear) {
       runnerDB->clearRunners();
@@ -1309,13 +1315,14 @@ void oEvent::importXML_IOF_Data(const wstring &clubfile,
 
     int personCount = 0;
     int duplicateCount = 0;
-    xmlobject xo=xml_cmp.getObject("CompetitorList");
+    if (!streamIOF)
+      xo = xml_cmp.getObject("CompetitorList");
 
-    if (xo && xo.getAttrib("iofVersion")) {
+    if (streamIOF) {
       IOF30Interface reader(this, false, false);
 
       vector<string> idProviders;
-      reader.prescanCompetitorList(xo);
+      reader.prescanCompetitorList(xml_cmp, competitorfile);
       reader.getIdTypes(idProviders);
 
       if (idProviders.size() > 1) {
@@ -1329,7 +1336,7 @@ void oEvent::importXML_IOF_Data(const wstring &clubfile,
 
         reader.setPreferredIdType(preferredIdProvider, false);
       }
-      reader.readCompetitorList(gdibase, xo, onlyWithClub, personCount, duplicateCount);
+      reader.readCompetitorList(gdibase, xml_cmp, competitorfile, onlyWithClub, personCount, duplicateCount);
     }
     else {
       xmlList xl;
@@ -2679,10 +2686,27 @@ void oEvent::exportIOFSplits(IOFVersion version, const wchar_t *file,
                              bool withPartialResult,
                              bool teamsAsIndividual, bool unrollLoops,
                              bool includeStageInfo, bool forceSplitFee,
-                             bool useEventorQuirks) {
+                             bool useEventorQuirks,
+                             IOFResultCache *resultCache) {
   xmlparser xml;
 
   xml.openOutput(file, false);
+  exportIOFSplits(version, xml, oldStylePatrolExport, useUTC, classes, preferredIdTypes,
+                  cmpName, leg, withPartialResult, teamsAsIndividual, unrollLoops,
+                  includeStageInfo, forceSplitFee, useEventorQuirks, resultCache);
+  xml.closeOut();
+}
+
+void oEvent::exportIOFSplits(IOFVersion version, xmlparser &xml,
+                             bool oldStylePatrolExport, bool useUTC,
+                             const set<int> &classes,
+                             const tuple<string, string, bool>& preferredIdTypes,
+                             const wstring &cmpName, int leg,
+                             bool withPartialResult,
+                             bool teamsAsIndividual, bool unrollLoops,
+                             bool includeStageInfo, bool forceSplitFee,
+                             bool useEventorQuirks,
+                             IOFResultCache *resultCache) {
   oClass::initClassId(*this, classes);
   reEvaluateAll(classes, true);
   if (version != IOF20)
@@ -2704,6 +2728,7 @@ void oEvent::exportIOFSplits(IOFVersion version, const wchar_t *file,
     else {
       IOF30Interface writer(this, forceSplitFee, useEventorQuirks);
       writer.setPreferredIdType(make_pair(get<0>(preferredIdTypes), get<1>(preferredIdTypes)), get<2>(preferredIdTypes));
+      writer.setResultCache(resultCache);
       writer.writeResultList(xml, classes, leg, useUTC,
         teamsAsIndividual, unrollLoops,
         includeStageInfo, withPartialResult);
@@ -2714,8 +2739,6 @@ void oEvent::exportIOFSplits(IOFVersion version, const wchar_t *file,
     Name = std::move(nameOrig);
     throw;
   }
-
-  xml.closeOut();
 }
 
 void oEvent::exportIOFStartlist(IOFVersion version, const wchar_t *file, bool useUTC,
@@ -2727,8 +2750,20 @@ void oEvent::exportIOFStartlist(IOFVersion version, const wchar_t *file, bool us
                                 bool useEventorQuirks) {
   xmlparser xml;
   
-  oClass::initClassId(*this, classes);
   xml.openOutput(file, false);
+  exportIOFStartlist(version, xml, useUTC, classes, preferredIdTypes,
+                     teamsAsIndividual, includeStageInfo, forceSplitFee, useEventorQuirks);
+  xml.closeOut();
+}
+
+void oEvent::exportIOFStartlist(IOFVersion version, xmlparser &xml, bool useUTC,
+                                const set<int> &classes,
+                                const tuple<string, string, bool>& preferredIdTypes,
+                                bool teamsAsIndividual,
+                                bool includeStageInfo,
+                                bool forceSplitFee,
+                                bool useEventorQuirks) {
+  oClass::initClassId(*this, classes);
 
   if (version == IOF20)
     exportIOFStartlist(xml);
@@ -2737,5 +2772,4 @@ void oEvent::exportIOFStartlist(IOFVersion version, const wchar_t *file, bool us
     writer.setPreferredIdType(make_pair(get<0>(preferredIdTypes), get<1>(preferredIdTypes)), get<2>(preferredIdTypes));
     writer.writeStartList(xml, classes, useUTC, teamsAsIndividual, includeStageInfo);
   }
-  xml.closeOut();
 }
@@ -924,6 +924,10 @@ void oRunner::addCard(pCard card, vector<pair<int, pControl>> &missingPunches) {
   int oldFinishTime = getFinishTime();
   pCard oldCard = Card;
 
+  // The result event covers the revisions of both the card and the runner
+  long revision = oe->getRevision();
+  card->synchronize();
+
   if (Card && card != Card) {
     Card->tOwner = nullptr;
   }
@@ -1007,6 +1011,8 @@ void oRunner::addCard(pCard card, vector<pair<int, pControl>> &missingPunches) {
   oe->pushDirectChange();
   if (oldCard && Card && oldCard != Card && oldCard->isConstructedFromPunches())
     oldCard->remove(); // Remove card constructed from punches
+
+  oe->pushResultEvent(this, oPunch::PunchFinish, getFinishTime(), revision);
 }
 
 pCourse oRunner::getCourse(bool useAdaptedCourse) const {
@@ -2087,14 +2093,76 @@ bool oRunner::sortSplit(const oRunner &a, const oRunner &b)
       if (a.tempRT!=b.tempRT)
         return a.tempRT<b.tempRT;
     }
-    return CompareString(LOCALE_USER_DEFAULT, 0,
-                        a.tRealName.c_str(), a.tRealName.length(),
-                        b.tRealName.c_str(), b.tRealName.length()) == CSTR_LESS_THAN;
+    return a.getNameKey() < b.getNameKey();
   }
 }
 
 bool oRunner::operator<(const oRunner &c) const {
-  if (oe->CurrentSortOrder == ClubClassStartTime) {
+  return lessThan(c, oe->CurrentSortOrder);
+}
+
+bool oRunner::hasSortKey(SortOrder so) {
+  switch (so) {
+  case ClassStartTime:
+  case ClassResult:
+  case ClassDefaultResult:
+  case ClassFinishTime:
+  case SortByName:
+    return true;
+  }
+  return false;
+}
+
+void oRunner::getSortKey(SortOrder so, int bibRank, RunnerSortKey &key) const {
+  for (int i = 0; i < RunnerSortKey::numFields; i++)
+    key.field[i] = 0;
+  key.nameRank = 0;
+
+  // Runners without class first, not ordered (see lessThan)
+  const oClass *myClass = getClassRef(true);
+  if (!myClass)
+    return;
+
+  key.field[0] = 1;
+  key.nameRank = 1;
+  if (so == SortByName)
+    return;
+
+  key.field[1] = myClass->tSortIndex;
+  key.field[2] = myClass->Id;
+  if (Class == myClass && Class->getClassStatus() != oClass::ClassStatus::Normal)
+    return;
+
+  if (so == ClassStartTime) {
+    // Runners without start time last
+    key.field[3] = tStartTime <= 0 ? 1 : 0;
+    key.field[4] = tStartTime;
+    key.field[5] = bibRank;
+  }
+  else if (so == ClassResult || so == ClassDefaultResult) {
+    RunnerStatus stat = so == ClassResult ? getStatusComputed(false) : tStatus;
+    if (stat == StatusUnknown)
+      stat = StatusOK;
+
+    key.field[3] = tLegEquClass;
+    key.field[4] = tDuplicateLeg;
+    key.field[5] = RunnerStatusOrderMap[stat];
+    if (stat == StatusOK && !Class->getNoTiming()) {
+      key.field[6] = getNumShortening();
+      int t = getRunningTime(so == ClassResult);
+      key.field[7] = t > 0 ? t : timeConstHour * 1000;
+    }
+  }
+  else if (so == ClassFinishTime) {
+    RunnerStatus stat = getStatusComputed(false);
+    key.field[3] = RunnerStatusOrderMap[stat];
+    if (stat == StatusOK)
+      key.field[4] = getFinishTimeAdjusted(true);
+  }
+}
+
+bool oRunner::lessThan(const oRunner &c, SortOrder so) const {
+  if (so == ClubClassStartTime) {
     pClub cl = getClubRef();
     pClub ocl = c.getClubRef();
     if (cl != ocl) {
@@ -2109,11 +2177,9 @@ bool oRunner::operator<(const oRunner &c) const {
   if (!myClass || !cClass)
     return size_t(myClass) < size_t(cClass);
   else if (Class == cClass && Class->getClassStatus() != oClass::ClassStatus::Normal)
-    return CompareString(LOCALE_USER_DEFAULT, 0,
-                         tRealName.c_str(), tRealName.length(),
-                         c.tRealName.c_str(), c.tRealName.length()) == CSTR_LESS_THAN;
+    return getNameKey() < c.getNameKey();
 
-  if (oe->CurrentSortOrder == ClassStartTime || oe->CurrentSortOrder == ClubClassStartTime) {
+  if (so == ClassStartTime || so == ClubClassStartTime) {
     if (myClass->Id != cClass->Id) {
       if (myClass->tSortIndex != cClass->tSortIndex)
         return myClass->tSortIndex < cClass->tSortIndex;
@@ -2137,7 +2203,7 @@ bool oRunner::operator<(const oRunner &c) const {
       }
     }
   }
-  if (oe->CurrentSortOrder == ClassStartTime) {
+  if (so == ClassStartTime) {
     if (myClass->Id != cClass->Id) {
       if (myClass->tSortIndex != cClass->tSortIndex)
         return myClass->tSortIndex < cClass->tSortIndex;
@@ -2161,7 +2227,7 @@ bool oRunner::operator<(const oRunner &c) const {
       }
     }
   }
-  else if (oe->CurrentSortOrder == ClassDefaultResult) {
+  else if (so == ClassDefaultResult) {
     RunnerStatus stat = tStatus == StatusUnknown ? StatusOK : tStatus;
     RunnerStatus cstat = c.tStatus == StatusUnknown ? StatusOK : c.tStatus;
 
@@ -2176,9 +2242,7 @@ bool oRunner::operator<(const oRunner &c) const {
     else {
       if (stat == StatusOK) {
         if (Class->getNoTiming()) {
-          return CompareString(LOCALE_USER_DEFAULT, 0,
-                               tRealName.c_str(), tRealName.length(),
-                               c.tRealName.c_str(), c.tRealName.length()) == CSTR_LESS_THAN;
+          return getNameKey() < c.getNameKey();
         }
         int s = getNumShortening();
         int cs = c.getNumShortening();
@@ -2197,7 +2261,7 @@ bool oRunner::operator<(const oRunner &c) const {
       }
     }
   }
-  else if (oe->CurrentSortOrder == ClassResult) {
+  else if (so == ClassResult) {
     
     RunnerStatus stat = getStatusComputed(false);
     RunnerStatus cstat = c.getStatusComputed(false);
@@ -2216,9 +2280,7 @@ bool oRunner::operator<(const oRunner &c) const {
     else {
       if (stat == StatusOK) {
         if (Class->getNoTiming()) {
-          return CompareString(LOCALE_USER_DEFAULT, 0,
-                               tRealName.c_str(), tRealName.length(),
-                               c.tRealName.c_str(), c.tRealName.length()) == CSTR_LESS_THAN;
+          return getNameKey() < c.getNameKey();
         }
         int s = getNumShortening();
         int cs = c.getNumShortening();
@@ -2237,7 +2299,7 @@ bool oRunner::operator<(const oRunner &c) const {
       }
     }
   }
-  else if (oe->CurrentSortOrder == ClassCourseResult) {
+  else if (so == ClassCourseResult) {
     if (myClass != cClass)
       return myClass->tSortIndex < cClass->tSortIndex;
 
@@ -2258,9 +2320,7 @@ bool oRunner::operator<(const oRunner &c) const {
     else {
       if (stat == StatusOK) {
         if (Class->getNoTiming()) {
-          return CompareString(LOCALE_USER_DEFAULT, 0,
-                               tRealName.c_str(), tRealName.length(),
-                               c.tRealName.c_str(), c.tRealName.length()) == CSTR_LESS_THAN;
+          return getNameKey() < c.getNameKey();
         }
         int s = getNumShortening();
         int cs = c.getNumShortening();
@@ -2274,12 +2334,10 @@ bool oRunner::operator<(const oRunner &c) const {
       }
     }
   }
-  else if (oe->CurrentSortOrder == SortByName) {
-    return CompareString(LOCALE_USER_DEFAULT, 0,
-                         tRealName.c_str(), tRealName.length(),
-                         c.tRealName.c_str(), c.tRealName.length()) == CSTR_LESS_THAN;
+  else if (so == SortByName) {
+    return getNameKey() < c.getNameKey();
   }
-  else if (oe->CurrentSortOrder == SortByLastName) {
+  else if (so == SortByLastName) {
     wstring a = getFamilyName();
     wstring b = c.getFamilyName();
     if (a.empty() && !b.empty())
@@ -2299,7 +2357,7 @@ bool oRunner::operator<(const oRunner &c) const {
                            b.c_str(), b.length()) == CSTR_LESS_THAN;
     }
   }
-  else if (oe->CurrentSortOrder == SortByFinishTime) {
+  else if (so == SortByFinishTime) {
     RunnerStatus stat = getStatusComputed(false);
     RunnerStatus cstat = c.getStatusComputed(false);
 
@@ -2312,13 +2370,13 @@ bool oRunner::operator<(const oRunner &c) const {
         return ft < cft;
     }
   }
-  else if (oe->CurrentSortOrder == SortByFinishTimeReverse) {
+  else if (so == SortByFinishTimeReverse) {
     int ft = getFinishTimeAdjusted(true);
     int cft = c.getFinishTimeAdjusted(true);
     if (ft != cft)
       return ft > cft;
   }
-  else if (oe->CurrentSortOrder == ClassFinishTime) {
+  else if (so == ClassFinishTime) {
     if (myClass != cClass)
       return myClass->tSortIndex < cClass->tSortIndex || (myClass->tSortIndex == cClass->tSortIndex && myClass->Id < cClass->Id);
 
@@ -2334,7 +2392,7 @@ bool oRunner::operator<(const oRunner &c) const {
         return ft < cft;
     }
   }
-  else if (oe->CurrentSortOrder == SortByStartTime) {
+  else if (so == SortByStartTime) {
     if (tStartTime < c.tStartTime)
       return true;
     else  if (tStartTime > c.tStartTime)
@@ -2346,7 +2404,7 @@ bool oRunner::operator<(const oRunner &c) const {
       return compareBib(b1, b2);
     }
   }
-  else if (oe->CurrentSortOrder == SortByStartTimeClass) {
+  else if (so == SortByStartTimeClass) {
     if (tStartTime < c.tStartTime)
       return true;
     else  if (tStartTime > c.tStartTime)
@@ -2355,7 +2413,7 @@ bool oRunner::operator<(const oRunner &c) const {
     if (myClass != cClass)
       return myClass->tSortIndex < cClass->tSortIndex || (myClass->tSortIndex == cClass->tSortIndex && myClass->Id < cClass->Id);
   }
-  else if (oe->CurrentSortOrder == SortByEntryTime) {
+  else if (so == SortByEntryTime) {
     auto dci = getDCI(), cdci = c.getDCI();
     int ed = dci.getInt("EntryDate");
     int ced = cdci.getInt("EntryDate");
@@ -2366,7 +2424,7 @@ bool oRunner::operator<(const oRunner &c) const {
     if (et != cet)
       return et > cet;
   }
-  else if (oe->CurrentSortOrder == SortByBib) {
+  else if (so == SortByBib) {
     const wstring &b = getBib();
     const wstring &bc = c.getBib();
     if (b != bc) {
@@ -2382,8 +2440,8 @@ bool oRunner::operator<(const oRunner &c) const {
     else
       return Id < c.Id;
   }
-  else if (oe->CurrentSortOrder == ClassPoints || oe->CurrentSortOrder == ClassTotalPoints) {
-    const bool total = oe->CurrentSortOrder == ClassTotalPoints;
+  else if (so == ClassPoints || so == ClassTotalPoints) {
+    const bool total = so == ClassTotalPoints;
     if (myClass != cClass)
       return myClass->tSortIndex < cClass->tSortIndex || (myClass->tSortIndex == cClass->tSortIndex && myClass->Id < cClass->Id);
     else if (tDuplicateLeg != c.tDuplicateLeg)
@@ -2411,7 +2469,7 @@ bool oRunner::operator<(const oRunner &c) const {
       }
     }
   }
-  else if (oe->CurrentSortOrder == ClassTotalResult) {
+  else if (so == ClassTotalResult) {
     if (myClass != cClass)
       return myClass->tSortIndex < cClass->tSortIndex || (myClass->tSortIndex == cClass->tSortIndex && myClass->Id < cClass->Id);
     else if (tDuplicateLeg != c.tDuplicateLeg)
@@ -2424,9 +2482,7 @@ bool oRunner::operator<(const oRunner &c) const {
         return s1 < s2;
       else if (s1 == StatusOK) {
         if (Class->getNoTiming()) {
-          return CompareString(LOCALE_USER_DEFAULT, 0,
-                               tRealName.c_str(), tRealName.length(),
-                               c.tRealName.c_str(), c.tRealName.length()) == CSTR_LESS_THAN;
+          return getNameKey() < c.getNameKey();
         }
         int t = getTotalRunningTime(FinishTime, true, true);
         int ct = c.getTotalRunningTime(c.FinishTime, true, true);
@@ -2435,7 +2491,7 @@ bool oRunner::operator<(const oRunner &c) const {
       }
     }
   }
-  else if (oe->CurrentSortOrder == CourseResult) {
+  else if (so == CourseResult) {
     const pCourse crs1 = getCourse(false);
     const pCourse crs2 = c.getCourse(false);
     RunnerStatus stat = getStatusComputed(false);
@@ -2464,7 +2520,7 @@ bool oRunner::operator<(const oRunner &c) const {
       }
     }
   }
-  else if (oe->CurrentSortOrder == CourseStartTime) {
+  else if (so == CourseStartTime) {
     const pCourse crs1 = getCourse(false);
     const pCourse crs2 = c.getCourse(false);
     if (crs1 != crs2) {
@@ -2475,7 +2531,7 @@ bool oRunner::operator<(const oRunner &c) const {
     else if (tStartTime != c.tStartTime)
       return tStartTime < c.tStartTime;
   }
-  else if (oe->CurrentSortOrder == ClassStartTimeClub) {
+  else if (so == ClassStartTimeClub) {
     if (myClass != cClass)
       return myClass->tSortIndex < cClass->tSortIndex || (myClass->tSortIndex == cClass->tSortIndex && myClass->Id < cClass->Id);
     else if (tStartTime != c.tStartTime) {
@@ -2491,7 +2547,7 @@ bool oRunner::operator<(const oRunner &c) const {
         return cres != 0;
     }
   }
-  else if (oe->CurrentSortOrder == ClassTeamLeg) {
+  else if (so == ClassTeamLeg) {
     if (myClass->Id != cClass->Id)
       return myClass->tSortIndex < cClass->tSortIndex || (myClass->tSortIndex == cClass->tSortIndex && myClass->Id < cClass->Id);
     else if (tInTeam != c.tInTeam) {
@@ -2520,16 +2576,14 @@ bool oRunner::operator<(const oRunner &c) const {
         return StartNo < c.StartNo;
     }
   }
-  else if (oe->CurrentSortOrder == ClassLiveResult) {
+  else if (so == ClassLiveResult) {
     if (myClass->Id != cClass->Id)
       return myClass->tSortIndex < cClass->tSortIndex || (myClass->tSortIndex == cClass->tSortIndex && myClass->Id < cClass->Id);
     
     if (currentControlTime != c.currentControlTime)
       return currentControlTime < c.currentControlTime;
   }
-  return CompareString(LOCALE_USER_DEFAULT, 0,
-                       tRealName.c_str(), tRealName.length(),
-                       c.tRealName.c_str(), c.tRealName.length()) == CSTR_LESS_THAN;
+  return getNameKey() < c.getNameKey();
 
 }
 
@@ -2907,6 +2961,7 @@ bool oRunner::isRentalCard(int cno) const {
 int oRunner::setCard(int cardId) {
   pCard c = cardId ? oe->getCard(cardId) : nullptr;
   int oldId = 0;
+  long revision = oe->getRevision();
 
   auto clearRG = [](pRunner r) {
     r->tRogaining.clear();
@@ -2920,9 +2975,10 @@ int oRunner::setCard(int cardId) {
       oldId = Card->getId();
       Card->tOwner = nullptr;
     }
+    pRunner otherR = nullptr;
     if (c) {
       if (c->tOwner) {
-        pRunner otherR = c->tOwner;
+        otherR = c->tOwner;
         assert(otherR != this);
         otherR->Card = nullptr;
         otherR->updateChanged();
@@ -2941,6 +2997,10 @@ int oRunner::setCard(int cardId) {
     evaluateCard(true, mp, 0, ChangeType::Update);
     updateChanged();
     synchronize(true);
+
+    oe->pushResultEvent(this, oPunch::PunchFinish, getFinishTime(), revision);
+    if (otherR)
+      oe->pushResultEvent(otherR, oPunch::PunchFinish, otherR->getFinishTime(), oe->getRevision());
   }
   return oldId;
 }
@@ -2952,6 +3012,7 @@ void oAbstractRunner::setName(const wstring &n, bool manualUpdate)
     throw std::exception("Tomt namn är inte tillåtet.");
   if (tn != sName){
     sName.swap(tn);
+    tNameKey.update(getName());
     if (manualUpdate)
       setFlag(FlagUpdateName, true);
     updateChanged();
@@ -2995,6 +3056,7 @@ void oRunner::setName(const wstring &in, bool manualUpdate)
     if (newRealName != tRealName || n != sName) {
       sName = n;
       tRealName = newRealName;
+      tNameKey.update(tRealName);
 
       if (manualUpdate)
         setFlag(FlagUpdateName, true);
@@ -3008,6 +3070,7 @@ void oRunner::setName(const wstring &in, bool manualUpdate)
       if (multiRunner[k] && n!=multiRunner[k]->sName) {
         multiRunner[k]->sName = n;
         multiRunner[k]->tRealName = tRealName;
+        multiRunner[k]->tNameKey.update(tRealName);
         multiRunner[k]->updateChanged();
       }
     }
@@ -3496,8 +3559,7 @@ void oEvent::getRunnersByCardNo(int cardNo, bool sortUpdate, CardLookupProperty
   }
   
   if (sortUpdate) {
-    const_cast<oEvent *>(this)->CurrentSortOrder = SortByName;
-    sort(out.begin(), out.end(), [](const pRunner &a, const pRunner &b) {return *a < *b; });
+    sort(out.begin(), out.end(), [](const pRunner &a, const pRunner &b) {return a->lessThan(*b, SortByName); });
   }
 }
 
@@ -6720,6 +6782,7 @@ void oRunner::init(const RunnerWDBEntry &dbr, bool updateOnlyExt) {
   if (updateOnlyExt) {
     dbr.getName(sName);
     getRealName(sName, tRealName);
+    tNameKey.update(tRealName);
     getDI().setString("Nationality", dbr.getNationality());
     getDI().setInt("BirthYear", dbr.dbe().getBirthDateInt());
     getDI().setString("Sex", dbr.getSex());
@@ -6729,6 +6792,7 @@ void oRunner::init(const RunnerWDBEntry &dbr, bool updateOnlyExt) {
     setTemporary();
     dbr.getName(sName);
     getRealName(sName, tRealName);
+    tNameKey.update(tRealName);
     cardNumber = dbr.dbe().cardNo;
     Club = oe->getRunnerDatabase().getClub(dbr.dbe().clubNo);
     getDI().setString("Nationality", dbr.getNationality());
@@ -6900,6 +6964,7 @@ void oRunner::markClassChanged(int controlId) {
 }
 
 void oRunner::changedObject() {
+  tNameKey.update(tRealName);
   markClassChanged(-1);
   sqlChanged = true;
   oe->sqlRunners.changed = true;
@@ -119,6 +119,25 @@ class oRunner;
 typedef oRunner* pRunner;
 typedef const oRunner* cRunner;
 
+/** Precomputed key for sorting runners in a given order. Keys are compared
+    field by field, then by rank of the name and last by original position. */
+struct RunnerSortKey {
+  static const int numFields = 8;
+  int field[numFields];
+  int nameRank;
+  int index;
+
+  bool operator<(const RunnerSortKey &k) const {
+    for (int i = 0; i < numFields; i++) {
+      if (field[i] != k.field[i])
+        return field[i] < k.field[i];
+    }
+    if (nameRank != k.nameRank)
+      return nameRank < k.nameRank;
+    return index < k.index;
+  }
+};
+
 class oTeam;
 typedef oTeam* pTeam;
 typedef const oTeam* cTeam;
@@ -129,6 +148,7 @@ struct SICard;
 class oAbstractRunner : public oBase {
 protected:
   wstring sName;
+  CollationKey tNameKey;
   pClub Club;
   pClass Class;
 
@@ -356,6 +376,8 @@ public:
 
   virtual void setName(const wstring &n, bool manualChange);
   virtual const wstring &getName() const {return sName;}
+  /** Key for locale ordered comparison of names.*/
+  const string &getNameKey() const {return tNameKey.get();}
 
   void setFinishTimeS(const wstring &t);
   virtual	void setFinishTime(int t);
@@ -537,6 +559,7 @@ public:
 
   friend class oListInfo;
   friend class GeneralResult;
+  friend class DynamicResult;
 };
 
 struct RunnerWDBEntry;
@@ -1120,9 +1143,20 @@ public:
   int getCardId() const {if (Card) return Card->Id; else return 0;}
 
   bool operator<(const oRunner &c) const;
+  /** Compare in the specified sort order.*/
+  bool lessThan(const oRunner &c, SortOrder so) const;
+
+  /** Return true if the sort order can be expressed by sort keys.*/
+  static bool hasSortKey(SortOrder so);
+  /** Compute the key for a sort order supported by sort keys. bibRank is the
+      rank of the bib among the sorted runners (used for ClassStartTime).
+      nameRank is set to 1 if the name is used to break ties, otherwise 0.*/
+  void getSortKey(SortOrder so, int bibRank, RunnerSortKey &key) const;
+
   bool static CompareCardNumber(const oRunner &a, const oRunner &b) { return a.cardNumber < b.cardNumber; }
 
   bool evaluateCard(bool applyTeam, vector<pair<int, pControl>> &missingPunches, int addPunch, ChangeType changeType);
+  /** Add a read out card. The card is synchronized first and a result event is pushed.*/
   void addCard(pCard card, vector<pair<int, pControl>> &missingPunches);
 
   /** Get split time for a controlId and optionally controlIndex on course (-1 means unknown, uses the first occurance on course)*/
@@ -837,14 +837,9 @@ int oAbstractRunner::compareClubs(const oClub* ca, const oClub* cb) {
     else if (cb == nullptr)
       return false;
 
-    const wstring an = ca->getName();
-    const wstring bn = cb->getName();
-    int res = CompareString(LOCALE_USER_DEFAULT, 0,
-      an.c_str(), an.length(),
-      bn.c_str(), bn.length());
-
-    if (res != CSTR_EQUAL)
-      return res == CSTR_LESS_THAN;
+    int res = ca->getNameKey().compare(cb->getNameKey());
+    if (res != 0)
+      return res < 0;
   }
   return 2;
 }
@@ -890,9 +885,7 @@ bool oTeam::compareResult(const oTeam &a, const oTeam &b)
     return aix < bix;
   }
 
-  return CompareString(LOCALE_USER_DEFAULT, 0,
-                       a.sName.c_str(), a.sName.length(),
-                       b.sName.c_str(), b.sName.length()) == CSTR_LESS_THAN;
+  return a.getNameKey() < b.getNameKey();
 }
 
 bool oTeam::compareResultNoSno(const oTeam &a, const oTeam &b)
@@ -927,9 +920,7 @@ bool oTeam::compareResultNoSno(const oTeam &a, const oTeam &b)
       return cres != 0;
   }
 
-  return CompareString(LOCALE_USER_DEFAULT, 0,
-                       a.sName.c_str(), a.sName.length(),
-                       b.sName.c_str(), b.sName.length()) == CSTR_LESS_THAN;
+  return a.getNameKey() < b.getNameKey();
 }
 
 
@@ -949,9 +940,7 @@ bool oTeam::compareSNO(const oTeam &a, const oTeam &b) {
     else return false;
   }
 
-  return CompareString(LOCALE_USER_DEFAULT, 0,
-                       a.sName.c_str(), a.sName.length(),
-                       b.sName.c_str(), b.sName.length()) == CSTR_LESS_THAN;
+  return a.getNameKey() < b.getNameKey();
 }
 
 bool oTeam::isRunnerUsed(int rId) const {
@@ -2371,21 +2360,6 @@ void oTeam::markClassChanged(int controlId) {
     Class->markSQLChanged(-1, controlId);
 }
 
-void oTeam::resetResultCalcCache() const {
-  resultCalculationCache.resize(RCCLast);
-  for (int k = 0; k < RCCLast; k++)
-    resultCalculationCache[k].resize(Runners.size());
-}
-
-vector< vector<int> > &oTeam::getResultCache(ResultCalcCacheSymbol symb) const {
-  return resultCalculationCache[symb];
-}
-
-void oTeam::setResultCache(ResultCalcCacheSymbol symb, int leg, vector<int> &data) const {
-  if (!resultCalculationCache.empty() && size_t(leg) < resultCalculationCache[symb].size())
-    resultCalculationCache[symb][leg].swap(data);
-}
-
 int oTeam::getNumShortening() const {
   return getNumShortening(-1);
 }
@@ -2674,6 +2648,7 @@ const pair<wstring, int> oTeam::getRaceInfo() {
 }
 
 void oTeam::changedObject() {
+  tNameKey.update(sName);
   markClassChanged(-1);
   sqlChanged = true;
   oe->sqlTeams.changed = true;
@@ -32,16 +32,6 @@ typedef const oTeam* cTeam;
 const unsigned int maxRunnersTeam=32;
 
 class oTeam final : public oAbstractRunner {
-public:
-  enum ResultCalcCacheSymbol {
-    RCCCourse,
-    RCCSplitTime,
-    RCCCardTimes,
-    RCCCardPunches,
-    RCCCardControls,
-    RCCLast
-  };
-
 private:
   int getLegRunningTimeUnadjusted(int leg, bool multidayTotal, bool useComputedRunnerTime) const;
   /** Return the total time the team has been resting (pursuit start etc.) up to the specified leg */
@@ -93,8 +83,6 @@ protected:
   mutable int tmpSortStatus;
   mutable RunnerStatus tmpCachedStatus;
 
-  mutable vector< vector< vector<int> > > resultCalculationCache;
-  
   struct RogainingResult {
     RogainingResult() { reset(); }
 
@@ -163,9 +151,6 @@ public:
     return 0; // Not supported
   }
 
-  void resetResultCalcCache() const;
-  vector< vector<int> > &getResultCache(ResultCalcCacheSymbol symb) const;
-  void setResultCache(ResultCalcCacheSymbol symb, int leg, vector<int> &data) const;
   void markClassChanged(int controlId);
 
   void setClub(const wstring &name) override;
@@ -170,6 +170,7 @@ pTeam oEvent::addTeam(const wstring &pname, int ClubId, int ClassId)
   Teams.push_back(t);
   pTeam pt = &Teams.back();
   pt->addToEvent(this, &t);
+  pt->tNameKey.update(pt->sName);
   teamById[t.Id] = pt;
 
   oe->updateTabs();
@@ -193,6 +194,7 @@ pTeam oEvent::addTeam(const oTeam &t, bool autoAssignStartNo) {
 
   pTeam pt = &Teams.back();
   pt->addToEvent(this, &t);
+  pt->tNameKey.update(pt->sName);
 
   for (size_t i = 0; i < pt->Runners.size(); i++) {
     if (pt->Runners[i]) {
@@ -1024,9 +1026,7 @@ static bool oTeam::compareGeneral(const oTeam& a, const oTeam& b) {
     return compareResult(a, b);
   }
 
-  return CompareString(LOCALE_USER_DEFAULT, 0,
-    a.getName().c_str(), a.getName().length(),
-    b.getName().c_str(), b.getName().length()) == CSTR_LESS_THAN;
+  return a.getNameKey() < b.getNameKey();
 }
 
 bool oEvent::sortTeams(SortOrder so, int leg, bool linearLeg) {
@@ -729,6 +729,7 @@ void OnlineInput::processPunches(oEvent &oe, const xmlList &punches) {
       return in * (timeConstSecond / 10);
   };
 
+  vector<oEvent::FreePunchInput> batch;
   for (size_t k = 0; k < punches.size(); k++) {
     int code = punches[k].getObjectInt("code");
     wstring startno, type;
@@ -787,13 +788,17 @@ void OnlineInput::processPunches(oEvent &oe, const xmlList &punches) {
       continue;
     }
 
-    oe.addFreePunch(time, code, originalCode, card, true, true);
+    batch.push_back({ time, code, originalCode, card, true });
 
     addInfo(L"Löpare: X, kontroll: Y, kl Z#" + rname + L"#" + oPunch::getType(code, r ? r->getCourse(false) : nullptr) + L"#" +  oe.getAbsTime(time));
   }
+  oe.addFreePunches(batch, true);
 }
 
 void OnlineInput::processPunches(oEvent &oe, list<vector<wstring>> &rocData) {
+  vector<oEvent::FreePunchInput> batch;
+  // Advanced when the batch is stored, so that punches are fetched again on an error
+  int batchLastId = lastImportedId;
   for (list< vector<wstring> >::iterator it = rocData.begin(); it != rocData.end(); ++it) {
     vector<wstring> &line = *it;
     if (line.size() == 4) {
@@ -823,87 +828,105 @@ void OnlineInput::processPunches(oEvent &oe, list<vector<wstring>> &rocData) {
         time = 0;
         addInfo(L"Ogiltig tid");
       }
-      oe.addFreePunch(time, code, originalCode, card, true, true);
+      batch.push_back({ time, code, originalCode, card, true });
 
-      lastImportedId = max(lastImportedId, punchId);
+      batchLastId = max(batchLastId, punchId);
 
       addInfo(L"Löpare: X, kontroll: Y, kl Z#" + rname + L"#" + oPunch::getType(code, r ? r->getCourse(false) : nullptr) + L"#" + oe.getAbsTime(time));
     }
-    else
+    else {
+      oe.addFreePunches(batch, true);
+      lastImportedId = batchLastId;
       throw meosException("Onlineservern svarade felaktigt.");
+    }
   }
+  oe.addFreePunches(batch, true);
+  lastImportedId = batchLastId;
 }
 
 void OnlineInput::processPunchesSICenter(oEvent &oe, const wstring& filename) {
 
-	time_t epoch_abs = getZeroTimeMSLinuxEpoch(oe);
+  time_t epoch_abs = getZeroTimeMSLinuxEpoch(oe);
 
-	std::wifstream file(filename);
-	if (!file.is_open())
-		return;
+  std::wifstream file(filename);
+  if (!file.is_open())
+    return;
 
-	wstring line;
+  wstring line;
 
-	// Skip the header
-	std::getline(file, line);
+  // Skip the header
+  std::getline(file, line);
 
-	while (std::getline(file, line)) {
-		wstringstream ss(line);
-		wstring field, type, cardstr;
+  vector<oEvent::FreePunchInput> batch;
+  // Advanced when the batch is stored, so that punches are fetched again on an error
+  int batchLastId = lastImportedId;
+  try {
+    while (std::getline(file, line)) {
+      wstringstream ss(line);
+      wstring field, type, cardstr;
 
-		int punchId, code, card, time;
+      int punchId, code, card, time;
 
-		std::getline(ss, field, L',');
-	    punchId = std::stoi(field);
+      std::getline(ss, field, L',');
+      punchId = std::stoi(field);
 
-		std::getline(ss, cardstr, L',');
-		card = std::stoi(cardstr);
+      std::getline(ss, cardstr, L',');
+      card = std::stoi(cardstr);
 
-		std::getline(ss, field, L',');
-		time_t epoch = std::stoll(field);
-        epoch -= epoch_abs; // in ms
-        time = (int)(epoch / 100); // in tenth of seconds
+      std::getline(ss, field, L',');
+      time_t epoch = std::stoll(field);
+      epoch -= epoch_abs; // in ms
+      time = (int)(epoch / 100); // in tenth of seconds
 
-		std::getline(ss, field, L',');
-		code = std::stoi(field);
+      std::getline(ss, field, L',');
+      code = std::stoi(field);
 
-    int originalCode = code;
-    std::getline(ss, type, L',');
-    if (type == L"Start")
-      code = oPunch::SpecialPunch::PunchStart;
-    else if (type == L"Finish")
-      code = oPunch::SpecialPunch::PunchFinish;
-    else if (type == L"Check" || type == L"Clear")
-      code = oPunch::SpecialPunch::PunchCheck;
-    else
-      code = mapPunch(code);
+      int originalCode = code;
+      std::getline(ss, type, L',');
+      if (type == L"Start")
+        code = oPunch::SpecialPunch::PunchStart;
+      else if (type == L"Finish")
+        code = oPunch::SpecialPunch::PunchFinish;
+      else if (type == L"Check" || type == L"Clear")
+        code = oPunch::SpecialPunch::PunchCheck;
+      else
+        code = mapPunch(code);
 
-    if (!oe.supportSubSeconds())
-      time -= (time % timeConstSecond);
+      if (!oe.supportSubSeconds())
+        time -= (time % timeConstSecond);
 
-		pRunner r = oe.getRunnerByCardNo(card, time, oEvent::CardLookupProperty::Any);
+      pRunner r = oe.getRunnerByCardNo(card, time, oEvent::CardLookupProperty::Any);
 
-		wstring rname;
-		if (r) {
-			rname = r->getName();
-			card = r->getCardNo();
-		}
-		else {
-			rname = lang.tl("Okänd") + L" (" + cardstr + L")";
-		}
+      wstring rname;
+      if (r) {
+        rname = r->getName();
+        card = r->getCardNo();
+      }
+      else {
+        rname = lang.tl("Okänd") + L" (" + cardstr + L")";
+      }
 
-		if (time < 0) {
-			time = 0;
-			addInfo(L"Ogiltig tid");
-		}
-		oe.addFreePunch(time, code, originalCode, card, true, true);
+      if (time < 0) {
+        time = 0;
+        addInfo(L"Ogiltig tid");
+      }
+      batch.push_back({ time, code, originalCode, card, true });
 
-		lastImportedId = max(lastImportedId, punchId);
+      batchLastId = max(batchLastId, punchId);
 
-		addInfo(L"Löpare: X, kontroll: Y, kl Z#" + rname + L"#" + oPunch::getType(code, r ? r->getCourse(false) : nullptr) + L"#" + oe.getAbsTime(time));
-	}
+      addInfo(L"Löpare: X, kontroll: Y, kl Z#" + rname + L"#" + oPunch::getType(code, r ? r->getCourse(false) : nullptr) + L"#" + oe.getAbsTime(time));
+    }
+  }
+  catch (...) {
+    // Keep punches read before the error
+    oe.addFreePunches(batch, true);
+    lastImportedId = batchLastId;
+    throw;
+  }
+  oe.addFreePunches(batch, true);
+  lastImportedId = batchLastId;
 
-	file.close();
+  file.close();
 }
 
 void OnlineInput::processCards(oEvent &oe, const xmlList &cards) {
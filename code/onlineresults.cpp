@@ -36,11 +36,314 @@
 #include "meosException.h"
 #include "Download.h"
 #include "xmlparser.h"
+#include "iof30interface.h"
 #include "progress.h"
 #include "machinecontainer.h"
 
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <chrono>
+
 int AutomaticCB(gdioutput *gdi, GuiEventType type, BaseInfo* data);
 
+/** Posts exported data to an online result server on a worker thread, so that a slow
+    or failing server does not block the user interface. Payloads are posted in order.
+    A complete payload replaces all payloads queued before it, and queued incremental
+    payloads are merged. A failed upload is retried with exponential backoff.*/
+class OnlineUploader {
+public:
+  struct Payload {
+    wstring url;
+    vector<pair<wstring, wstring>> headers;
+    bool useZip = false;
+    // Replaces all earlier payloads
+    bool complete = false;
+    // XML documents, posted in order
+    vector<string> parts;
+    size_t nextPart = 0;
+    int serializeTime = 0;
+  };
+
+  struct Statistics {
+    int uploaded = 0;
+    int failed = 0;
+    int coalesced = 0;
+    int queued = 0;
+    int lastPayloadSize = 0;
+    int lastSerializeTime = 0;
+    int lastUploadTime = 0;
+    int retryDelay = 0;
+    int64_t bytesSent = 0;
+  };
+
+  OnlineUploader() : worker([this]() { run(); }) {}
+
+  ~OnlineUploader() {
+    {
+      lock_guard<mutex> lg(lock);
+      stop = true;
+    }
+    wakeUp.notify_all();
+    worker.join();
+  }
+
+  void upload(Payload &&payload);
+
+  /** True if an incremental payload was lost, so that the next payload must be complete.*/
+  bool needComplete() const {
+    lock_guard<mutex> lg(lock);
+    return lostIncremental;
+  }
+
+  /** Get the error of the last failed upload, if not already taken.*/
+  bool takeError(string &message, vector<string> &responseLines) {
+    lock_guard<mutex> lg(lock);
+    if (errorMessage.empty())
+      return false;
+    message.swap(errorMessage);
+    responseLines.swap(errorResponse);
+    errorMessage.clear();
+    errorResponse.clear();
+    return true;
+  }
+
+  Statistics getStatistics() const {
+    lock_guard<mutex> lg(lock);
+    return statistics;
+  }
+
+private:
+  static constexpr size_t maxQueuedParts = 256;
+  static constexpr int maxRetryDelay = 60;
+  // Bounds each blocking WinINet call, and thereby how long the destructor waits for the worker
+  static constexpr DWORD requestTimeout = 20 * 1000;
+
+  mutable mutex lock;
+  condition_variable wakeUp;
+  bool stop = false;
+  deque<Payload> queue;
+  bool lostIncremental = false;
+  // Set if the server does not accept zip files
+  bool noZip = false;
+  string errorMessage;
+  vector<string> errorResponse;
+  Statistics statistics;
+  std::chrono::steady_clock::time_point retryTime;
+  // Must be last, started when the other members are initialized
+  std::thread worker;
+
+  void run();
+  /** Post the remaining parts of the payload. Returns the server status, empty for success.*/
+  string post(Download &dwl, Payload &payload, int &bytesSent, vector<string> &response);
+
+  static wstring getUploadFile();
+};
+
+void OnlineUploader::upload(Payload &&payload) {
+  {
+    lock_guard<mutex> lg(lock);
+    if (payload.complete) {
+      statistics.coalesced += int(queue.size());
+      queue.clear();
+      lostIncremental = false;
+    }
+    else if (!queue.empty()) {
+      // Merge with the queued payload
+      Payload &last = queue.back();
+      for (string &part : payload.parts)
+        last.parts.push_back(std::move(part));
+      last.serializeTime += payload.serializeTime;
+      statistics.coalesced++;
+    }
+
+    if (payload.complete || queue.empty())
+      queue.push_back(std::move(payload));
+
+    size_t parts = 0;
+    for (const Payload &p : queue)
+      parts += p.parts.size() - p.nextPart;
+
+    if (parts > maxQueuedParts) {
+      // Too far behind. The next export will be complete.
+      statistics.coalesced += int(queue.size());
+      queue.clear();
+      lostIncremental = true;
+    }
+    statistics.queued = int(queue.size());
+  }
+  wakeUp.notify_all();
+}
+
+wstring OnlineUploader::getUploadFile() {
+  wchar_t path[MAX_PATH];
+  wchar_t file[MAX_PATH];
+  GetTempPath(MAX_PATH, path);
+  if (!GetTempFileName(path, L"up", 0, file))
+    throw meosException("Failed to create temporary file.");
+  return file;
+}
+
+void OnlineUploader::run() {
+  Download dwl;
+  dwl.initInternet();
+  dwl.setTimeout(requestTimeout);
+
+  unique_lock<mutex> lg(lock);
+  while (!stop) {
+    if (queue.empty()) {
+      wakeUp.wait(lg);
+      continue;
+    }
+    if (std::chrono::steady_clock::now() < retryTime) {
+      wakeUp.wait_until(lg, retryTime);
+      continue;
+    }
+
+    Payload payload = std::move(queue.front());
+    queue.pop_front();
+    lg.unlock();
+
+    auto t0 = std::chrono::steady_clock::now();
+    int bytesSent = 0;
+    string status, error;
+    vector<string> response;
+    try {
+      status = post(dwl, payload, bytesSent, response);
+    }
+    catch (const meosException &ex) {
+      error = gdioutput::narrow(ex.wwhat());
+    }
+    catch (const std::exception &ex) {
+      error = ex.what();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    lg.lock();
+    statistics.bytesSent += bytesSent;
+    statistics.lastUploadTime = int(std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count());
+
+    // Server answers that will not change by retrying
+    bool permanent = status == "BADCMP" || status == "BADPWD";
+    if (status == "NOZIP" && !noZip) {
+      noZip = true; // Retry without zip at once
+      queue.push_front(std::move(payload));
+    }
+    else if (error.empty() && status.empty()) {
+      statistics.uploaded++;
+      statistics.lastPayloadSize = bytesSent;
+      statistics.lastSerializeTime = payload.serializeTime;
+      statistics.retryDelay = 0;
+    }
+    else {
+      statistics.failed++;
+      if (status == "BADCMP")
+        errorMessage = "Onlineservern svarade: Felaktigt tävlings-id";
+      else if (status == "BADPWD")
+        errorMessage = "Onlineservern svarade: Felaktigt lösenord";
+      else if (status == "NOZIP")
+        errorMessage = "Onlineservern svarade: ZIP stöds ej";
+      else if (status == "ERROR")
+        errorMessage = "Onlineservern svarade: Serverfel";
+      else if (status == "BADRESPONSE")
+        errorMessage = "Onlineservern svarade felaktigt.";
+      else if (!status.empty())
+        errorMessage = "Misslyckades med att ladda upp onlineresultat";
+      else
+        errorMessage = error;
+      errorResponse.swap(response);
+
+      if (permanent) {
+        lostIncremental = true;
+      }
+      else {
+        if (queue.empty() || !queue.front().complete)
+          queue.push_front(std::move(payload));
+        else
+          statistics.coalesced++; // Replaced by a complete payload
+
+        statistics.retryDelay = min(max(1, statistics.retryDelay * 2), maxRetryDelay);
+        retryTime = std::chrono::steady_clock::now() + std::chrono::seconds(statistics.retryDelay);
+      }
+    }
+    statistics.queued = int(queue.size());
+  }
+}
+
+string OnlineUploader::post(Download &dwl, Payload &payload, int &bytesSent, vector<string> &response) {
+  bool useZip;
+  {
+    lock_guard<mutex> lg(lock);
+    useZip = payload.useZip && !noZip;
+  }
+
+  while (payload.nextPart < payload.parts.size()) {
+    {
+      lock_guard<mutex> lg(lock);
+      if (stop)
+        return ""; // Shutting down, the rest is not posted
+    }
+    const string &part = payload.parts[payload.nextPart];
+    wstring file = getUploadFile();
+    {
+      ofstream fout(file.c_str(), ios::binary);
+      fout.write(part.data(), part.size());
+    }
+
+    bool zipPart = useZip && part.size() > 1024;
+    if (zipPart) {
+      wstring zipped = getUploadFile();
+      zip(zipped.c_str(), 0, vector<wstring>(1, file));
+      DeleteFile(file.c_str());
+      file = zipped;
+    }
+
+    struct _stat st;
+    if (_wstat(file.c_str(), &st) == 0)
+      bytesSent += st.st_size;
+
+    vector<pair<wstring, wstring>> headers = payload.headers;
+    headers.emplace_back(L"Content-Type", zipPart ? L"application/zip" : L"text/plain");
+
+    wstring result = getUploadFile();
+    ProgressWindow pw(nullptr, 1.0);
+    try {
+      dwl.postFile(payload.url, file, result, headers, pw);
+    }
+    catch (...) {
+      DeleteFile(file.c_str());
+      DeleteFile(result.c_str());
+      throw;
+    }
+    DeleteFile(file.c_str());
+
+    string answer;
+    {
+      ifstream is(result.c_str(), ios::binary);
+      answer.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+    }
+    DeleteFile(result.c_str());
+
+    // The xml parser is not used here since it is not thread safe
+    string status;
+    size_t tag = answer.find("<MOPStatus");
+    size_t attr = tag != string::npos ? answer.find("status=\"", tag) : string::npos;
+    if (attr != string::npos) {
+      attr += 8;
+      size_t end = answer.find('"', attr);
+      if (end != string::npos)
+        status = answer.substr(attr, end - attr);
+    }
+    if (status != "OK") {
+      split(answer, "\n", response);
+      return status.empty() ? "BADRESPONSE" : status;
+    }
+    payload.nextPart++;
+  }
+  return "";
+}
+
 static int OnlineCB(gdioutput *gdi, GuiEventType type, BaseInfo* data) {
   switch (type) {
     case GUI_BUTTON: {
@@ -77,6 +380,12 @@ OnlineResults::~OnlineResults() {
     delete infoServer;
 }
 
+OnlineUploader &OnlineResults::getUploader() {
+  if (!uploader)
+    uploader = make_shared<OnlineUploader>();
+  return *uploader;
+}
+
 int OnlineResults::processButton(gdioutput &gdi, ButtonInfo &bi) {
 
   if (bi.id == "ToURL")
@@ -404,6 +713,17 @@ void OnlineResults::status(gdioutput &gdi)
     gdi.addString("", 0, "Antal skickade uppdateringar X (Y kb)#" +
                           itos(exportCounter-1) + "#" + itos(bytesExported/1024));
   }
+  if (sendToURL && uploader) {
+    OnlineUploader::Statistics st = uploader->getStatistics();
+    gdi.popX();
+    gdi.dropLine(1);
+    gdi.addString("", 0, "Uppladdning: X kb på Y ms (förberett på Z ms)#" + itos(st.lastPayloadSize / 1024) +
+                  "#" + itos(st.lastUploadTime) + "#" + itos(st.lastSerializeTime));
+    gdi.addString("", 0, "I kö: X, sammanslagna: Y, misslyckade: Z#" + itos(st.queued) +
+                  "#" + itos(st.coalesced) + "#" + itos(st.failed));
+    if (st.retryDelay > 0)
+      gdi.addString("", 0, "Nytt försök om X s#" + itos(st.retryDelay));
+  }
   gdi.popX();
 
   gdi.dropLine(2);
@@ -416,6 +736,13 @@ void OnlineResults::status(gdioutput &gdi)
 void OnlineResults::process(gdioutput &gdi, oEvent *oe, AutoSyncType ast) {
   processProtected(gdi, ast, [&]() {
     errorLines.clear();
+    if (uploader) {
+      string error;
+      if (uploader->takeError(error, errorLines)) {
+        formatError(gdi);
+        throw meosException(error);
+      }
+    }
     uint64_t tick = GetTickCount64();
     if (lastSync + interval * 1000 > tick)
       return;
@@ -450,7 +777,15 @@ void OnlineResults::process(gdioutput &gdi, oEvent *oe, AutoSyncType ast) {
       if (ic.synchronize(*oe, getCompetitionName(*oe).first, InfoCompetition::SynchType::All, 
                          classes, useCtrlSet, controls, dataType != DataType::MOP10)) {
         lastSync = tick; // If error, avoid to quick retry
-        ic.getDiffXML(xmlbuff);
+        if (sendToURL && getUploader().needComplete())
+          ic.getCompleteXML(xmlbuff);
+        else
+          ic.getDiffXML(xmlbuff);
+      }
+      else if (sendToURL && getUploader().needComplete()) {
+        // An incremental upload was lost
+        lastSync = tick;
+        ic.getCompleteXML(xmlbuff);
       }
     }
     else {
@@ -458,9 +793,18 @@ void OnlineResults::process(gdioutput &gdi, oEvent *oe, AutoSyncType ast) {
       if (dataType == DataType::IOF2)
         oe->exportIOFSplits(oEvent::IOF20, t.c_str(), false, false,
           classes, make_tuple("", "", true), getCompetitionName(*oe).first, -1, false, false, true, true, false, false);
-      else if (dataType == DataType::IOF3)
+      else if (dataType == DataType::IOF3) {
+        if (!iofResultCache)
+          iofResultCache = make_shared<IOFResultCache>();
         oe->exportIOFSplits(oEvent::IOF30, t.c_str(), false, false,
-          classes, make_tuple("", "", true), getCompetitionName(*oe).first, -1, true, false, true, true, false, false);
+          classes, make_tuple("", "", true), getCompetitionName(*oe).first, -1, true, false, true, true, false, false,
+          iofResultCache.get());
+#ifdef _DEBUG
+        string info = "IOF export: " + itos(iofResultCache->getSerialized()) + " serialized, " +
+                      itos(iofResultCache->getReused()) + " reused\n";
+        OutputDebugStringA(info.c_str());
+#endif
+      }
       else
         throw meosException("Internal error");
     }
@@ -502,105 +846,39 @@ void OnlineResults::process(gdioutput &gdi, oEvent *oe, AutoSyncType ast) {
       constexpr int buffLimit = 64;
 
       if (sendToURL) {
-        Download dwl;
-        dwl.initInternet();
-        ProgressWindow pw(nullptr, gdi.getScale());
-        vector<pair<wstring, wstring>> key;
-        key.emplace_back(L"competition", OnlineInput::sanitizeId(cmpId));
+        OnlineUploader::Payload payload;
+        payload.url = url;
+        payload.headers.emplace_back(L"competition", OnlineInput::sanitizeId(cmpId));
         if (!passwd.empty())
-          key.emplace_back(L"pwd", passwd);
-
-        bool addedHeader = false;
-        bool forceZIP = false;
-        bool forceNoZip = false;
+          payload.headers.emplace_back(L"pwd", passwd);
+        payload.useZip = zipFile;
 
-        bool moreToWrite = true;
-        string tmp;
-        const int total = max<int>(xmlbuff.size(), 1u);
-
-        while (moreToWrite) {
-          t = getTempFile();
-          xmlparser xmlOut;
-          xmlbuff.startXML(xmlOut, t);
-          moreToWrite = xmlbuff.commit(xmlOut, buffLimit);
-          xmlOut.endTag();
-          xmlSize = xmlOut.closeOut();
-          wstring result = getTempFile();
-          bool wasZip = false;
-          if (!forceNoZip && ((zipFile && xmlSize > 1024) || forceZIP)) {
-            wstring zipped = getTempFile();
-            zip(zipped.c_str(), 0, vector<wstring>(1, t));
-            removeTempFile(t);
-            t = zipped;
-            wasZip = true;
-            struct _stat st;
-            _wstat(t.c_str(), &st);
-            bytesExported += st.st_size;
-          }
-          else
-            bytesExported += xmlSize;
-
-
-          if (!addedHeader) {
-            if (wasZip) {
-              forceZIP = true;
-              key.emplace_back(L"Content-Type", L"application/zip");
-            }
-            else {
-              forceNoZip = true;
-              key.emplace_back(L"Content-Type", L"text/plain");
-            }
-            addedHeader = true;
+        if (xmlbuff.size() > 0) {
+          payload.complete = xmlbuff.isComplete();
+          bool moreToWrite = true;
+          while (moreToWrite) {
+            xmlparser xmlOut;
+            xmlOut.openMemoryOutput(false);
+            xmlbuff.startTagXML(xmlOut);
+            moreToWrite = xmlbuff.commit(xmlOut, buffLimit);
+            xmlOut.endTag();
+            payload.parts.emplace_back();
+            xmlOut.getMemoryOutput(payload.parts.back());
+            bytesExported += payload.parts.back().size();
           }
-
-          dwl.postFile(url, t, result, key, pw);
+        }
+        else {
+          payload.complete = true;
+          ifstream is(t.c_str(), ios::binary);
+          payload.parts.emplace_back(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+          is.close();
           removeTempFile(t);
-
-          pwMain.setProgress(1000 - (1000 * xmlbuff.size()) / total);
-
-          xmlparser xml;
-          xmlobject res;
-          try {
-            xml.read(result);
-            res = xml.getObject("MOPStatus");
-          }
-          catch (std::exception&) {
-            ifstream is(result.c_str());
-            is.seekg(0, is.end);
-            int length = (int)is.tellg();
-            is.seekg(0, is.beg);
-            char* buffer = new char[length + 1];
-            is.read(buffer, length);
-            is.close();
-            removeTempFile(result);
-            buffer[length] = 0;
-            OutputDebugStringA(buffer);
-            split(buffer, "\n", errorLines);
-            delete[] buffer;
-            formatError(gdi);
-            throw meosException("Onlineservern svarade felaktigt.");
-          }
-          removeTempFile(result);
-
-          if (res)
-            res.getObjectString("status", tmp);
-          if (tmp == "BADCMP")
-            throw meosException("Onlineservern svarade: Felaktigt tävlings-id");
-          if (tmp == "BADPWD")
-            throw meosException("Onlineservern svarade: Felaktigt lösenord");
-          if (tmp == "NOZIP")
-            throw meosException("Onlineservern svarade: ZIP stöds ej");
-          if (tmp == "ERROR")
-            throw meosException("Onlineservern svarade: Serverfel");
-
-          if (tmp != "OK")
-            break;
+          bytesExported += payload.parts.back().size();
         }
-
-        if (tmp == "OK")
-          ic.commitComplete();
-        else
-          throw meosException("Misslyckades med att ladda upp onlineresultat");
+        payload.serializeTime = int(GetTickCount64() - tick);
+        getUploader().upload(std::move(payload));
+        // The uploader retries until the data is sent, or requests a complete export
+        ic.commitComplete();
       }
 
       lastSync = GetTickCount64();
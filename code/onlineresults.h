@@ -24,6 +24,8 @@
 #include "TabAuto.h"
 
 class InfoCompetition;
+class IOFResultCache;
+class OnlineUploader;
 
 class OnlineResults :
   public AutoMachine
@@ -55,6 +57,11 @@ protected:
   wstring storedName;
 
   mutable InfoCompetition *infoServer;
+  // Serialized runners of the last IOF 3.0 export
+  shared_ptr<IOFResultCache> iofResultCache;
+  // Posts exported data to the URL on a worker thread
+  shared_ptr<OnlineUploader> uploader;
+  OnlineUploader &getUploader();
   wstring exportScript;
   int exportCounter;
   int sessionNumberOffset = 0;
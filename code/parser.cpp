@@ -242,8 +242,7 @@ ParseNode *Parser::parseValue(const string &word, const string &expr, size_t &po
     if (expr[pos] == '[') {
       size_t start = pos + 1;
       matchSE(expr, pos, '[', ']');
-      ArrayValueNode *arr = getArrayValue();
-      arr->expr = word;
+      ArrayValueNode *arr = getArrayValue(word);
       arr->index = parseStatement(expr.substr(start, pos-start-1), false);
       
       eatWhite(expr, pos);
@@ -272,7 +271,7 @@ ParseNode *Parser::parseValue(const string &word, const string &expr, size_t &po
       un->op = OpNone;
 
       if (sword == "size") {
-        if (isMatrix(word))
+        if (isMatrix(getSlot(word)))
           un->op = OpSizeBase;
         else  
           un->op = OpSize;
@@ -282,18 +281,14 @@ ParseNode *Parser::parseValue(const string &word, const string &expr, size_t &po
       }
 
       if (un->op != OpNone) {
-        ValueNode *vn = getValue();
-        vn->value = word;
-        un->right = vn;
+        un->right = getValue(word);
         return un;
       }
       else
         throw meosException("Unknown method X#" + word + "." + sword);
     }
   }
-  ValueNode *vn = getValue();
-  vn->value = word;
-  return vn;
+  return getValue(word);
 }
 
 
@@ -740,125 +735,154 @@ ParseNode *Parser::parse(const string &expr) {
   }
 }
 
-int Parser::evaluate(const string &input) const {
-  if (input.empty())
-    throw meosException("Empty expression");
+int Parser::getSlot(const string &name) {
+  auto res = slotIndex.find(name);
+  if (res != slotIndex.end())
+    return res->second;
 
-  if (isdigit(input[0]))
-    return atoi(input.c_str());
+  int slot = slots.size();
+  slots.emplace_back();
+  slots.back().name = name;
+  slotIndex[name] = slot;
+  return slot;
+}
 
-  {
-    map<string, Symbol>::const_iterator res = symb.find(input);
-    if (res != symb.end()) {
-      if (res->second.value.empty())
-        throw meosException("Internal error");
-      if (res->second.value[0].size() == 1)
-        return res->second.value[0][0];
-      throw meosException("X is an array.#" + input);
-    }
-  }
+int Parser::findSlot(const string &name) const {
+  auto res = slotIndex.find(name);
+  if (res != slotIndex.end())
+    return res->second;
+  return -1;
+}
+
+vector<int> Parser::getSortedSlots() const {
+  vector<int> sorted(slots.size());
+  for (size_t k = 0; k < sorted.size(); k++)
+    sorted[k] = k;
+  sort(sorted.begin(), sorted.end(), [this](int a, int b) {return slots[a].name < slots[b].name; });
+  return sorted;
+}
 
-  map<string, vector<int> >::iterator res = var.find(input);
-  if (res != var.end()) {
-    if (res->second.size() == 1)
-      return res->second[0];
-    throw meosException("X is an array.#" + input);
+void Parser::bindDeferred(int slot) const {
+  if (symbolProvider)
+    symbolProvider(slots[slot].symbol.deferKey);
+
+  if (slots[slot].symbol.deferKey >= 0) {
+    slots[slot].symbol.deferKey = -1;
+    throw meosException("Internal error");
   }
-  throw meosException("Unknown symbol X#" + input);
 }
 
-int Parser::evaluate(const string &input, int index, int index2) const {
-  if (input.empty())
-    throw meosException("Empty expression");
+int Parser::evaluate(int slot) const {
+  const Slot &s = getBound(slot);
+  if (s.isSymbol) {
+    if (s.symbol.value.empty())
+      throw meosException("Internal error");
+    if (s.symbol.value[0].size() == 1)
+      return s.symbol.value[0][0];
+    throw meosException("X is an array.#" + s.name);
+  }
 
-  if (isdigit(input[0]))
-    return atoi(input.c_str());
+  if (s.isVariable) {
+    if (s.var.size() == 1)
+      return s.var[0];
+    throw meosException("X is an array.#" + s.name);
+  }
+  throw meosException("Unknown symbol X#" + s.name);
+}
 
-  map<string, Symbol>::const_iterator res = symb.find(input);
-  if (res != symb.end()) {
-    if (size_t(index2) < res->second.value.size() && 
-        size_t(index) < res->second.value[index2].size())
-      return res->second.value[index2][index];
+int Parser::evaluate(int slot, int index, int index2) const {
+  const Slot &s = getBound(slot);
+  if (s.isSymbol) {
+    if (size_t(index2) < s.symbol.value.size() && 
+        size_t(index) < s.symbol.value[index2].size())
+      return s.symbol.value[index2][index];
     if (index2 == 0)
-      throw meosException("Index X in Y is out of range.#" + itos(index) + "#" + input);
+      throw meosException("Index X in Y is out of range.#" + itos(index) + "#" + s.name);
     else
-      throw meosException("Index X in Y is out of range.#" + itos(index2) + "," + itos(index) + "#" + input);
+      throw meosException("Index X in Y is out of range.#" + itos(index2) + "," + itos(index) + "#" + s.name);
   }
 
-  map<string, vector<int> >::const_iterator res2 = var.find(input);
-  if (res2 != var.end()) {
+  if (s.isVariable) {
     if (index2 != 0)
-      throw meosException("Index X in Y is out of range.#" + itos(index2) + "#" + input);
-    if (size_t(index) < res2->second.size())
-      return res2->second[index];
-    throw meosException("Index X in Y is out of range.#" + itos(index) + "#" + input);
+      throw meosException("Index X in Y is out of range.#" + itos(index2) + "#" + s.name);
+    if (size_t(index) < s.var.size())
+      return s.var[index];
+    throw meosException("Index X in Y is out of range.#" + itos(index) + "#" + s.name);
   }
-  throw meosException("Unknown symbol X#" + input);
+  throw meosException("Unknown symbol X#" + s.name);
 }
 
-int Parser::evaluateSize(const string &input, int index) const {
-  if (input.empty())
-    throw meosException("Empty expression");
-
-  if (isdigit(input[0]))
+int Parser::evaluateSize(int slot, int index) const {
+  const Slot &s = getBound(slot);
+  if (isdigit(s.name[0]))
     throw meosException("Constant expression");
-  {
-    map<string, Symbol >::const_iterator res = symb.find(input);
 
-    if (res != symb.end()) {
-      if (index == -1) 
-        return res->second.value.size();
-      else {
-        if (size_t(index) < res->second.value.size())
-          return res->second.value[index].size();
-        else
-          throw meosException("Index out of range for X.#" + input);
-      }
+  if (s.isSymbol) {
+    if (index == -1) 
+      return s.symbol.value.size();
+    else {
+      if (size_t(index) < s.symbol.value.size())
+        return s.symbol.value[index].size();
+      else
+        throw meosException("Index out of range for X.#" + s.name);
     }
   }
 
-  map<string, vector<int> >::const_iterator res = var.find(input);
-  if (res != var.end()) {
+  if (s.isVariable) {
     if (index != 0)
-      throw meosException("Index out of range for X.#" + input);
-    return res->second.size();
+      throw meosException("Index out of range for X.#" + s.name);
+    return s.var.size();
   }
-  throw meosException("Unknown symbol X#" + input);
+  throw meosException("Unknown symbol X#" + s.name);
 }
 
-void Parser::sortArray(const string &input) const {
-  map<string, vector<int> >::iterator res = var.find(input);
-  if (res != var.end()) {
-    sort(res->second.begin(), res->second.end());
+void Parser::sortArray(int slot) const {
+  Slot &s = slots[slot];
+  if (s.isVariable) {
+    sort(s.var.begin(), s.var.end());
     return;
   }
-  throw meosException("Unknown symbol X#" + input);
+  throw meosException("Unknown symbol X#" + s.name);
 }
 
-void Parser::storeVariable(const string &input, const vector<int> &value) const {  
-  if (symb.count(input))
-    throw meosException("Duplicate symbol X#" + input);
-  var[input] = value;
+void Parser::storeVariable(int slot, const vector<int> &value) const {  
+  Slot &s = slots[slot];
+  if (s.isSymbol)
+    throw meosException("Duplicate symbol X#" + s.name);
+  if (!s.isVariable) {
+    s.isVariable = true;
+    usedVariables.push_back(slot);
+  }
+  s.var = value;
 }
 
-void Parser::storeVariable(const string &input, int value) const {
-  if (symb.count(input))
-    throw meosException("Duplicate symbol X#" + input);
-  vector<int> &iv = var[input];
-  iv.resize(1);
-  iv[0] = value;
+void Parser::storeVariable(int slot, int value) const {
+  Slot &s = slots[slot];
+  if (s.isSymbol)
+    throw meosException("Duplicate symbol X#" + s.name);
+  if (!s.isVariable) {
+    s.isVariable = true;
+    usedVariables.push_back(slot);
+  }
+  s.var.resize(1);
+  s.var[0] = value;
 }
 
-void Parser::storeVariable(const string &input, int index, int value) const {
-  if (symb.count(input))
-    throw meosException("Duplicate symbol X#" + input);
+void Parser::storeVariable(int slot, int index, int value) const {
+  Slot &s = slots[slot];
+  if (s.isSymbol)
+    throw meosException("Duplicate symbol X#" + s.name);
   if (index < 0 || index>1024)
-    throw meosException("Index out of range for X.#" + input);
+    throw meosException("Index out of range for X.#" + s.name);
 
-  vector<int> &iv = var[input];
-  if (iv.size() <= size_t(index))
-    iv.resize(index+1);
-  iv[index] = value;
+  if (!s.isVariable) {
+    s.isVariable = true;
+    usedVariables.push_back(slot);
+    s.var.clear();
+  }
+  if (s.var.size() <= size_t(index))
+    s.var.resize(index+1);
+  s.var[index] = value;
 }
 
 Parser::Parser() {
@@ -887,14 +911,24 @@ Parser::BinaryOperatorNode *Parser::getBinary() {
   return (BinaryOperatorNode *)nodes.back();
 }
 
-Parser::ValueNode *Parser::getValue() {
-  nodes.push_back(new ValueNode());
-  return (ValueNode *)nodes.back();
+Parser::ValueNode *Parser::getValue(const string &word) {
+  ValueNode *vn = new ValueNode();
+  nodes.push_back(vn);
+  vn->value = word;
+  vn->slot = getSlot(word);
+  if (isdigit(word[0])) {
+    vn->literal = true;
+    vn->constant = atoi(word.c_str());
+  }
+  return vn;
 }
 
-Parser::ArrayValueNode *Parser::getArrayValue() {
-  nodes.push_back(new ArrayValueNode());
-  return (ArrayValueNode *)nodes.back();
+Parser::ArrayValueNode *Parser::getArrayValue(const string &word) {
+  ArrayValueNode *arr = new ArrayValueNode();
+  nodes.push_back(arr);
+  arr->expr = word;
+  arr->slot = getSlot(word);
+  return arr;
 }
 
 Parser::StatementNode *Parser::getStatement() {
@@ -957,7 +991,9 @@ Parser::ValueNode::~ValueNode() {
 }
 
 int Parser::ValueNode::evaluate(const Parser &parser) const {
-  return parser.evaluate(value);
+  if (literal)
+    return constant;
+  return parser.evaluate(slot);
 }
 bool Parser::ValueNode::isVariable() const {
   return value.length()>0 && isalpha(value[0]);
@@ -1015,17 +1051,17 @@ int Parser::BinaryOperatorNode::evaluate(const Parser &parser) const {
   case OpAssign: {
     ValueNode *vn = dynamic_cast<ValueNode *>(right);
     if (vn != 0) {
-      if (parser.isMatrix(vn->value))
+      if (parser.isMatrix(vn->slot))
         throw meosException("Cannot assign matrix X#"+vn->value);
-      if (parser.isVector(vn->value)) {
-        left->assignVector(parser, parser.getVector(vn->value, 0));
+      if (parser.isVector(vn->slot)) {
+        left->assignVector(parser, parser.getVector(vn->slot, 0));
         parser.ignoreValue = true;
         return -1;
       }
     }
     ArrayValueNode *avn = dynamic_cast<ArrayValueNode *>(right);
-    if (avn != 0 && parser.isMatrix(avn->expr) && avn->index2 == 0) {
-      left->assignVector(parser, parser.getVector(avn->expr, avn->index->evaluate(parser)));
+    if (avn != 0 && parser.isMatrix(avn->slot) && avn->index2 == 0) {
+      left->assignVector(parser, parser.getVector(avn->slot, avn->index->evaluate(parser)));
       parser.ignoreValue = true;
       return -1;
     }
@@ -1094,19 +1130,19 @@ int Parser::UnaryOperatorNode::evaluate(const Parser &parser) const {
     }
     case OpSize: {
        ValueNode &vn= dynamic_cast<ValueNode &>(*right);
-       return parser.evaluateSize(vn.value, 0);
+       return parser.evaluateSize(vn.slot, 0);
     }
     case OpSizeBase: {
        ValueNode &vn= dynamic_cast<ValueNode &>(*right);
-       return parser.evaluateSize(vn.value, -1);
+       return parser.evaluateSize(vn.slot, -1);
     }
     case OpSizeSub: {
       ArrayValueNode &vn= dynamic_cast<ArrayValueNode &>(*right);
-      return parser.evaluateSize(vn.expr, vn.index->evaluate(parser));
+      return parser.evaluateSize(vn.slot, vn.index->evaluate(parser));
     }
     case OpSortArray: {
        ValueNode &vn= dynamic_cast<ValueNode &>(*right);
-       parser.sortArray(vn.value);
+       parser.sortArray(vn.slot);
        parser.ignoreValue = true;
        return -1;
     }
@@ -1218,9 +1254,9 @@ Parser::ArrayValueNode::~ArrayValueNode() {
 
 int Parser::ArrayValueNode::evaluate(const Parser &parser) const {
   if (index2 == 0)
-    return parser.evaluate(expr, index->evaluate(parser), 0);
+    return parser.evaluate(slot, index->evaluate(parser), 0);
   else
-    return parser.evaluate(expr, index->evaluate(parser), index2->evaluate(parser));
+    return parser.evaluate(slot, index->evaluate(parser), index2->evaluate(parser));
 }
 
 bool Parser::ArrayValueNode::isVariable() const {
@@ -1236,11 +1272,11 @@ void ParseNode::assignVector(const Parser &parser, const vector<int> &value) con
 }
  
 void Parser::ValueNode::assign(const Parser &parser, int in_value) const {
-  parser.storeVariable(value, in_value);
+  parser.storeVariable(slot, in_value);
 }
 
 void Parser::ValueNode::assignVector(const Parser &parser, const vector<int> &in_value) const {
-  parser.storeVariable(value, in_value);
+  parser.storeVariable(slot, in_value);
 }
 
 
@@ -1248,105 +1284,881 @@ void Parser::ArrayValueNode::assign(const Parser &parser, int value) const {
   int ix2;
   if (index2 != 0 && (ix2 = index2->evaluate(parser)) != 0)
       throw meosException("Index X in Y is out of range.#" + itos(ix2) + "#" + expr); 
-  parser.storeVariable(expr, index->evaluate(parser), value);
+  parser.storeVariable(slot, index->evaluate(parser), value);
 }
 
 void Parser::ArrayValueNode::assignVector(const Parser &parser, const vector<int> &in_value) const {
   if (in_value.size() != 1)
     throw meosException("Vector cannot be assigned to X[i]#" + expr);
-  parser.storeVariable(expr, index->evaluate(parser), in_value[0]);
+  parser.storeVariable(slot, index->evaluate(parser), in_value[0]);
+}
+
+void ParseProgram::setTarget(int ix, int target) {
+  if (code[ix].op == CTestVector || code[ix].op == CTestMatrix)
+    code[ix].b = target;
+  else
+    code[ix].a = target;
+}
+
+void ParseProgram::clear() {
+  code.clear();
+  numTemporary = 0;
+}
+
+void ParseNode::compileAssign(ParseProgram &prg) const {
+  prg.emit(ParseProgram::CIllegalAssignment);
+}
+
+void ParseNode::compileAssignVector(ParseProgram &prg, int source) const {
+  prg.emit(ParseProgram::CIllegalAssignment);
+}
+
+void Parser::StatementNode::compile(ParseProgram &prg) const {
+  if (node == 0) {
+    prg.emit(ParseProgram::CNullStatement);
+    return;
+  }
+  int ret = prg.getTemporary();
+  prg.emit(ParseProgram::CInitTemp, ret, 0);
+  prg.emit(ParseProgram::CClearBreak);
+  vector<int> exits;
+  for (const StatementNode *c = this; c; c = c->next) {
+    prg.emit(ParseProgram::CClearIgnore);
+    c->node->compile(prg);
+    prg.emit(ParseProgram::CSetRet, ret);
+    if (c->next)
+      exits.push_back(prg.emit(ParseProgram::CJumpIfBreak));
+  }
+  for (int ix : exits)
+    prg.setTarget(ix, prg.label());
+  prg.emit(ParseProgram::CGetTemp, ret);
+}
+
+void Parser::ValueNode::compile(ParseProgram &prg) const {
+  if (literal)
+    prg.emit(ParseProgram::CPush, constant);
+  else
+    prg.emit(ParseProgram::CLoad, slot);
+}
+
+void Parser::ValueNode::compileAssign(ParseProgram &prg) const {
+  prg.emit(ParseProgram::CStore, slot);
+}
+
+void Parser::ValueNode::compileAssignVector(ParseProgram &prg, int source) const {
+  prg.emit(ParseProgram::CStoreVector, slot, source);
+}
+
+void Parser::ArrayValueNode::compile(ParseProgram &prg) const {
+  index->compile(prg);
+  if (index2 == 0)
+    prg.emit(ParseProgram::CLoadAt, slot);
+  else {
+    index2->compile(prg);
+    prg.emit(ParseProgram::CLoadAt2, slot);
+  }
+}
+
+void Parser::ArrayValueNode::compileAssign(ParseProgram &prg) const {
+  if (index2 != 0) {
+    index2->compile(prg);
+    prg.emit(ParseProgram::CCheckZero, slot);
+  }
+  index->compile(prg);
+  prg.emit(ParseProgram::CStoreAt, slot);
+}
+
+void Parser::ArrayValueNode::compileAssignVector(ParseProgram &prg, int source) const {
+  prg.emit(ParseProgram::CLoadSingle, source, slot);
+  index->compile(prg);
+  prg.emit(ParseProgram::CStoreAt, slot);
+  prg.emit(ParseProgram::CPop);
+}
+
+void Parser::BinaryOperatorNode::compile(ParseProgram &prg) const {
+  if (left == 0 || right == 0)
+    throw meosException("Internal error");
+
+  ParseProgram::OpCode code;
+  switch (op) {
+  case OpPlus:
+    code = ParseProgram::CAdd;
+    break;
+  case OpMinus:
+    code = ParseProgram::CSub;
+    break;
+  case OpTimes:
+    code = ParseProgram::CMul;
+    break;
+  case OpDivide:
+    code = ParseProgram::CDiv;
+    break;
+  case OpMod:
+    code = ParseProgram::CMod;
+    break;
+
+  case OpEquals:
+    code = ParseProgram::CEquals;
+    break;
+  case OpNotEquals:
+    code = ParseProgram::CNotEquals;
+    break;
+  case OpLess:
+    code = ParseProgram::CLess;
+    break;
+  case OpLessEquals:
+    code = ParseProgram::CLessEquals;
+    break;
+  case OpMore:
+    code = ParseProgram::CMore;
+    break;
+  case OpMoreEquals:
+    code = ParseProgram::CMoreEquals;
+    break;
+
+  case OpMax:
+    code = ParseProgram::CMax;
+    break;
+  case OpMin:
+    code = ParseProgram::CMin;
+    break;
+
+  case OpOr:
+  case OpAnd: {
+    // Short circuit, result is 0 or 1
+    left->compile(prg);
+    int shortCut = prg.emit(op == OpAnd ? ParseProgram::CJumpIfZero : ParseProgram::CJumpIfNotZero);
+    right->compile(prg);
+    prg.emit(ParseProgram::CBool);
+    int end = prg.emit(ParseProgram::CJump);
+    prg.setTarget(shortCut, prg.label());
+    prg.emit(ParseProgram::CPush, op == OpAnd ? 0 : 1);
+    prg.setTarget(end, prg.label());
+    return;
+  }
+
+  case OpAssign: {
+    // Assignment of arrays depends on the symbols and variables when run
+    int scalar = -1, end = -1;
+    const ValueNode *vn = dynamic_cast<const ValueNode *>(right);
+    const ArrayValueNode *avn = dynamic_cast<const ArrayValueNode *>(right);
+    if (vn != 0 && !vn->literal) {
+      scalar = prg.emit(ParseProgram::CTestVector, vn->slot);
+      prg.emit(ParseProgram::CPush, 0);
+      left->compileAssignVector(prg, vn->slot);
+    }
+    else if (avn != 0 && avn->index2 == 0) {
+      scalar = prg.emit(ParseProgram::CTestMatrix, avn->slot);
+      avn->index->compile(prg);
+      left->compileAssignVector(prg, avn->slot);
+    }
+
+    if (scalar != -1) {
+      prg.emit(ParseProgram::CIgnore);
+      end = prg.emit(ParseProgram::CJump);
+      prg.setTarget(scalar, prg.label());
+    }
+
+    right->compile(prg);
+    left->compileAssign(prg);
+
+    if (end != -1)
+      prg.setTarget(end, prg.label());
+    return;
+  }
+
+  default:
+    throw meosException("Internal error, unknown operator");
+  }
+
+  left->compile(prg);
+  right->compile(prg);
+  prg.emit(code);
+}
+
+void Parser::UnaryOperatorNode::compile(ParseProgram &prg) const {
+  if (op == OpBreak) {
+    prg.emit(ParseProgram::CBreak);
+    return;
+  }
+
+  if (right == 0)
+    throw meosException("Internal error");
+
+  switch (op) {
+    case OpReturn:
+      right->compile(prg);
+      prg.emit(ParseProgram::CReturn);
+      return;
+    case OpMinus:
+      right->compile(prg);
+      prg.emit(ParseProgram::CNeg);
+      return;
+    case OpNot:
+      right->compile(prg);
+      prg.emit(ParseProgram::CNot);
+      return;
+    case OpPlus:
+      right->compile(prg);
+      return;
+    case OpIncPost:
+    case OpDecPost:
+      right->compile(prg);
+      prg.emit(ParseProgram::CDup);
+      prg.emit(ParseProgram::CPush, op == OpIncPost ? 1 : -1);
+      prg.emit(ParseProgram::CAdd);
+      right->compileAssign(prg);
+      prg.emit(ParseProgram::CPop);
+      return;
+    case OpIncPre:
+    case OpDecPre:
+      right->compile(prg);
+      prg.emit(ParseProgram::CPush, op == OpIncPre ? 1 : -1);
+      prg.emit(ParseProgram::CAdd);
+      right->compileAssign(prg);
+      return;
+    case OpSize: {
+      const ValueNode &vn = dynamic_cast<const ValueNode &>(*right);
+      prg.emit(ParseProgram::CSize, vn.slot);
+      return;
+    }
+    case OpSizeBase: {
+      const ValueNode &vn = dynamic_cast<const ValueNode &>(*right);
+      prg.emit(ParseProgram::CSizeBase, vn.slot);
+      return;
+    }
+    case OpSizeSub: {
+      const ArrayValueNode &vn = dynamic_cast<const ArrayValueNode &>(*right);
+      vn.index->compile(prg);
+      prg.emit(ParseProgram::CSizeSub, vn.slot);
+      return;
+    }
+    case OpSortArray: {
+      const ValueNode &vn = dynamic_cast<const ValueNode &>(*right);
+      prg.emit(ParseProgram::CSort, vn.slot);
+      prg.emit(ParseProgram::CIgnore);
+      return;
+    }
+  }
+
+  throw meosException("Internal error, unknown operator");
+}
+
+void Parser::IfNode::compile(ParseProgram &prg) const {
+  condition->compile(prg);
+  int toFalse = prg.emit(ParseProgram::CJumpIfZero);
+  iftrue->compile(prg);
+  int end = prg.emit(ParseProgram::CJump);
+  prg.setTarget(toFalse, prg.label());
+  if (iffalse)
+    iffalse->compile(prg);
+  else
+    prg.emit(ParseProgram::CIgnore);
+  prg.setTarget(end, prg.label());
+}
+
+void Parser::WhileNode::compile(ParseProgram &prg) const {
+  if (condition == 0 || body == 0)
+    throw meosException("Internal error in while");
+  int ret = prg.getTemporary();
+  int used = prg.getTemporary();
+  int count = prg.getTemporary();
+  prg.emit(ParseProgram::CInitTemp, ret, -1);
+  prg.emit(ParseProgram::CInitTemp, used, 0);
+  prg.emit(ParseProgram::CInitTemp, count, 1000);
+
+  int start = prg.label();
+  condition->compile(prg);
+  int toEnd = prg.emit(ParseProgram::CJumpIfZero);
+  prg.emit(ParseProgram::CLoopCount, count, 0);
+  body->compile(prg);
+  prg.emit(ParseProgram::CSetTemp, ret);
+  int toBreak = prg.emit(ParseProgram::CBreakLoop);
+  prg.emit(ParseProgram::CInitTemp, used, 1);
+  prg.emit(ParseProgram::CJump, start);
+
+  prg.setTarget(toEnd, prg.label());
+  prg.setTarget(toBreak, prg.label());
+  prg.emit(ParseProgram::CIgnoreIfZero, used);
+  prg.emit(ParseProgram::CGetTemp, ret);
+}
+
+void Parser::ForNode::compile(ParseProgram &prg) const {
+  if (start == 0 || condition == 0 || update == 0 || body == 0)
+    throw meosException("Internal error in for");
+  int ret = prg.getTemporary();
+  int used = prg.getTemporary();
+  int count = prg.getTemporary();
+  prg.emit(ParseProgram::CInitTemp, ret, -1);
+  prg.emit(ParseProgram::CInitTemp, used, 0);
+  prg.emit(ParseProgram::CInitTemp, count, 1000);
+
+  start->compile(prg);
+  prg.emit(ParseProgram::CPop);
+  int loop = prg.label();
+  condition->compile(prg);
+  int toEnd = prg.emit(ParseProgram::CJumpIfZero);
+  prg.emit(ParseProgram::CLoopCount, count, 1);
+  body->compile(prg);
+  prg.emit(ParseProgram::CSetTemp, ret);
+  prg.emit(ParseProgram::CInitTemp, used, 1);
+  update->compile(prg);
+  prg.emit(ParseProgram::CPop);
+  prg.emit(ParseProgram::CJump, loop);
+
+  prg.setTarget(toEnd, prg.label());
+  prg.emit(ParseProgram::CIgnoreIfZero, used);
+  prg.emit(ParseProgram::CGetTemp, ret);
+}
+
+void Parser::compile(const ParseNode *pn, ParseProgram &prg) const {
+  prg.clear();
+  pn->compile(prg);
+}
+
+int Parser::execute(const ParseProgram &prg) const {
+  typedef ParseProgram P;
+  stack.clear();
+  temporary.assign(prg.numTemporary, 0);
+  breakMode = 0;
+  ignoreValue = false;
+
+  auto pop = [this]() {
+    int v = stack.back();
+    stack.pop_back();
+    return v;
+  };
+
+  const P::Instruction *code = prg.code.data();
+  const int size = prg.code.size();
+  int pc = 0;
+  int r;
+  while (pc < size) {
+    const P::Instruction &ins = code[pc++];
+    switch (ins.op) {
+    case P::CPush:
+      stack.push_back(ins.a);
+      break;
+    case P::CPop:
+      stack.pop_back();
+      break;
+    case P::CDup:
+      stack.push_back(stack.back());
+      break;
+    case P::CLoad:
+      stack.push_back(evaluate(ins.a));
+      break;
+    case P::CLoadAt:
+      stack.back() = evaluate(ins.a, stack.back(), 0);
+      break;
+    case P::CLoadAt2:
+      r = pop();
+      stack.back() = evaluate(ins.a, stack.back(), r);
+      break;
+    case P::CStore:
+      storeVariable(ins.a, stack.back());
+      break;
+    case P::CStoreAt:
+      r = pop();
+      storeVariable(ins.a, r, stack.back());
+      break;
+    case P::CCheckZero:
+      r = pop();
+      if (r != 0)
+        throw meosException("Index X in Y is out of range.#" + itos(r) + "#" + slots[ins.a].name);
+      break;
+    case P::CStoreVector:
+      r = pop();
+      storeVariable(ins.a, getVector(ins.b, r));
+      break;
+    case P::CLoadSingle: {
+      const vector<int> &v = getVector(ins.a, stack.back());
+      if (v.size() != 1)
+        throw meosException("Vector cannot be assigned to X[i]#" + slots[ins.b].name);
+      stack.back() = v[0];
+      break;
+    }
+    case P::CTestVector:
+      if (isMatrix(ins.a))
+        throw meosException("Cannot assign matrix X#" + slots[ins.a].name);
+      if (!isVector(ins.a))
+        pc = ins.b;
+      break;
+    case P::CTestMatrix:
+      if (!isMatrix(ins.a))
+        pc = ins.b;
+      break;
+    case P::CSize:
+      stack.push_back(evaluateSize(ins.a, 0));
+      break;
+    case P::CSizeBase:
+      stack.push_back(evaluateSize(ins.a, -1));
+      break;
+    case P::CSizeSub:
+      stack.back() = evaluateSize(ins.a, stack.back());
+      break;
+    case P::CSort:
+      sortArray(ins.a);
+      break;
+
+    case P::CAdd:
+      r = pop();
+      stack.back() += r;
+      break;
+    case P::CSub:
+      r = pop();
+      stack.back() -= r;
+      break;
+    case P::CMul:
+      r = pop();
+      stack.back() *= r;
+      break;
+    case P::CDiv:
+      r = pop();
+      stack.back() /= r;
+      break;
+    case P::CMod:
+      r = pop();
+      stack.back() %= r;
+      break;
+    case P::CEquals:
+      r = pop();
+      stack.back() = stack.back() == r;
+      break;
+    case P::CNotEquals:
+      r = pop();
+      stack.back() = stack.back() != r;
+      break;
+    case P::CLess:
+      r = pop();
+      stack.back() = stack.back() < r;
+      break;
+    case P::CLessEquals:
+      r = pop();
+      stack.back() = stack.back() <= r;
+      break;
+    case P::CMore:
+      r = pop();
+      stack.back() = stack.back() > r;
+      break;
+    case P::CMoreEquals:
+      r = pop();
+      stack.back() = stack.back() >= r;
+      break;
+    case P::CMax:
+      r = pop();
+      stack.back() = max(stack.back(), r);
+      break;
+    case P::CMin:
+      r = pop();
+      stack.back() = min(stack.back(), r);
+      break;
+    case P::CNeg:
+      stack.back() = -stack.back();
+      break;
+    case P::CNot:
+      stack.back() = stack.back() == 0;
+      break;
+    case P::CBool:
+      stack.back() = stack.back() != 0;
+      break;
+
+    case P::CJump:
+      pc = ins.a;
+      break;
+    case P::CJumpIfZero:
+      if (pop() == 0)
+        pc = ins.a;
+      break;
+    case P::CJumpIfNotZero:
+      if (pop() != 0)
+        pc = ins.a;
+      break;
+    case P::CInitTemp:
+      temporary[ins.a] = ins.b;
+      break;
+    case P::CSetTemp:
+      temporary[ins.a] = pop();
+      break;
+    case P::CGetTemp:
+      stack.push_back(temporary[ins.a]);
+      break;
+    case P::CSetRet:
+      r = pop();
+      if (!ignoreValue)
+        temporary[ins.a] = r;
+      break;
+    case P::CClearIgnore:
+      ignoreValue = false;
+      break;
+    case P::CIgnore:
+      ignoreValue = true;
+      stack.push_back(-1);
+      break;
+    case P::CIgnoreIfZero:
+      if (temporary[ins.a] == 0)
+        ignoreValue = true;
+      break;
+    case P::CClearBreak:
+      breakMode = 0;
+      break;
+    case P::CJumpIfBreak:
+      if (breakMode > 0)
+        pc = ins.a;
+      break;
+    case P::CBreakLoop:
+      if (breakMode > 0) {
+        breakMode--;
+        pc = ins.a;
+      }
+      break;
+    case P::CBreak:
+      breakMode = 1;
+      ignoreValue = true;
+      stack.push_back(-1);
+      break;
+    case P::CLoopCount:
+      if (--temporary[ins.a] <= 0)
+        throw meosException(ins.b == 0 ? "Stalled while loop" : "Stalled for loop");
+      break;
+    case P::CReturn:
+      return stack.back();
+    case P::CNullStatement:
+      throw meosException("Nullpointer");
+    case P::CIllegalAssignment:
+      throw meosException("Illegal assignment");
+    default:
+      throw meosException("Internal error, unknown operator");
+    }
+  }
+
+  if (stack.empty())
+    throw meosException("Internal error");
+  return stack.back();
+}
+
+int Parser::getColumnStackSize(const ParseProgram &prg, const vector<Column> &columns,
+                               vector<const int *> &slotValues) const {
+  typedef ParseProgram P;
+  slotValues.assign(slots.size(), nullptr);
+  for (const Column &c : columns) {
+    int slot = findSlot(c.symbol);
+    if (slot < 0)
+      continue;
+    const Slot &s = slots[slot];
+    if (c.values)
+      slotValues[slot] = c.values;
+    else if (s.isSymbol && s.symbol.deferKey < 0 && s.symbol.value.size() == 1 && s.symbol.value[0].size() == 1)
+      slotValues[slot] = &s.symbol.value[0][0];
+  }
+
+  int depth = 0;
+  int maxDepth = 0;
+  for (size_t k = 0; k < prg.code.size(); k++) {
+    const P::Instruction &ins = prg.code[k];
+    switch (ins.op) {
+    case P::CPush:
+      depth++;
+      break;
+    case P::CLoad:
+      if (slotValues[ins.a] == nullptr)
+        return 0;
+      depth++;
+      break;
+    case P::CAdd:
+    case P::CSub:
+    case P::CMul:
+    case P::CDiv:
+    case P::CMod:
+    case P::CEquals:
+    case P::CNotEquals:
+    case P::CLess:
+    case P::CLessEquals:
+    case P::CMore:
+    case P::CMoreEquals:
+    case P::CMax:
+    case P::CMin:
+      if (depth < 2)
+        return 0;
+      depth--;
+      break;
+    case P::CNeg:
+    case P::CNot:
+    case P::CBool:
+      if (depth < 1)
+        return 0;
+      break;
+    case P::CReturn:
+      if (k + 1 != prg.code.size())
+        return 0;
+      break;
+    default:
+      return 0;
+    }
+    maxDepth = max(maxDepth, depth);
+  }
+  return depth == 1 ? maxDepth : 0;
+}
+
+bool Parser::isColumnProgram(const ParseProgram &prg, const vector<Column> &columns) const {
+  vector<const int *> slotValues;
+  return getColumnStackSize(prg, columns, slotValues) > 0;
+}
+
+// Simple loops over a block of rows, which the compiler vectorizes
+template<typename Op> static void columnOp(int *x, const int *y, int n, Op op) {
+  for (int i = 0; i < n; i++)
+    x[i] = op(x[i], y[i]);
+}
+
+template<typename Op> static void columnOp(int *x, int n, Op op) {
+  for (int i = 0; i < n; i++)
+    x[i] = op(x[i]);
+}
+
+void Parser::executeColumns(const ParseProgram &prg, const vector<Column> &columns, int rows, int *result) const {
+  typedef ParseProgram P;
+  vector<const int *> slotValues;
+  const int stackSize = getColumnStackSize(prg, columns, slotValues);
+  if (stackSize == 0)
+    throw meosException("Internal error");
+
+  vector<bool> broadcast(slots.size(), true);
+  for (const Column &c : columns) {
+    int slot = findSlot(c.symbol);
+    if (slot >= 0 && c.values)
+      broadcast[slot] = false;
+  }
+
+  const int block = 256;
+  vector<int> buffer(stackSize * block);
+  for (int first = 0; first < rows; first += block) {
+    const int n = min(block, rows - first);
+    int depth = 0;
+    for (const P::Instruction &ins : prg.code) {
+      int *x = depth >= 2 ? &buffer[(depth - 2) * block] : nullptr;
+      int *y = depth >= 1 ? &buffer[(depth - 1) * block] : nullptr;
+      switch (ins.op) {
+      case P::CPush:
+        fill_n(&buffer[depth++ * block], n, ins.a);
+        break;
+      case P::CLoad:
+        if (broadcast[ins.a])
+          fill_n(&buffer[depth++ * block], n, *slotValues[ins.a]);
+        else
+          copy_n(slotValues[ins.a] + first, n, &buffer[depth++ * block]);
+        break;
+      case P::CAdd:
+        columnOp(x, y, n, [](int a, int b) {return a + b;});
+        depth--;
+        break;
+      case P::CSub:
+        columnOp(x, y, n, [](int a, int b) {return a - b;});
+        depth--;
+        break;
+      case P::CMul:
+        columnOp(x, y, n, [](int a, int b) {return a * b;});
+        depth--;
+        break;
+      case P::CDiv:
+        columnOp(x, y, n, [](int a, int b) {return a / b;});
+        depth--;
+        break;
+      case P::CMod:
+        columnOp(x, y, n, [](int a, int b) {return a % b;});
+        depth--;
+        break;
+      case P::CEquals:
+        columnOp(x, y, n, [](int a, int b) {return int(a == b);});
+        depth--;
+        break;
+      case P::CNotEquals:
+        columnOp(x, y, n, [](int a, int b) {return int(a != b);});
+        depth--;
+        break;
+      case P::CLess:
+        columnOp(x, y, n, [](int a, int b) {return int(a < b);});
+        depth--;
+        break;
+      case P::CLessEquals:
+        columnOp(x, y, n, [](int a, int b) {return int(a <= b);});
+        depth--;
+        break;
+      case P::CMore:
+        columnOp(x, y, n, [](int a, int b) {return int(a > b);});
+        depth--;
+        break;
+      case P::CMoreEquals:
+        columnOp(x, y, n, [](int a, int b) {return int(a >= b);});
+        depth--;
+        break;
+      case P::CMax:
+        columnOp(x, y, n, [](int a, int b) {return max(a, b);});
+        depth--;
+        break;
+      case P::CMin:
+        columnOp(x, y, n, [](int a, int b) {return min(a, b);});
+        depth--;
+        break;
+      case P::CNeg:
+        columnOp(y, n, [](int a) {return -a;});
+        break;
+      case P::CNot:
+        columnOp(y, n, [](int a) {return int(a == 0);});
+        break;
+      case P::CBool:
+        columnOp(y, n, [](int a) {return int(a != 0);});
+        break;
+      default:
+        break;
+      }
+    }
+    copy_n(&buffer[0], n, result + first);
+  }
 }
 
 void Parser::declareSymbol(const char *name, const string &desc, 
                            bool isVector, bool isMatrix, bool deprecated) {
-  assert(symb.count(name) == 0 || (symb[name].isVector == isVector && symb[name].isMatrix == isMatrix));
-  symb[name].desc = desc;
-  symb[name].isVector = isVector;
-  symb[name].isMatrix = isMatrix;
-  symb[name].deprecated = deprecated;
+  Slot &s = slots[getSlot(name)];
+  assert(!s.isSymbol || (s.symbol.isVector == isVector && s.symbol.isMatrix == isMatrix));
+  s.isSymbol = true;
+  s.symbol.desc = desc;
+  s.symbol.isVector = isVector;
+  s.symbol.isMatrix = isMatrix;
+  s.symbol.deprecated = deprecated;
 }
 
-bool Parser::isMatrix(const string &input) const {
-  map<string, Symbol>::const_iterator res = symb.find(input);
-  return res != symb.end() && res->second.isMatrix;
+bool Parser::isMatrix(int slot) const {
+  const Slot &s = slots[slot];
+  return s.isSymbol && s.symbol.isMatrix;
 }
 
-bool Parser::isVector(const string &input) const {
-  map<string, Symbol>::const_iterator res = symb.find(input);
-  if (res != symb.end()) 
-    return !res->second.isMatrix && res->second.value[0].size() != 1;
+bool Parser::isVector(int slot) const {
+  const Slot &s = getBound(slot);
+  if (s.isSymbol) 
+    return !s.symbol.isMatrix && (s.symbol.value.empty() || s.symbol.value[0].size() != 1);
 
-  map<string, vector<int> >::const_iterator resv = var.find(input);
-  return resv != var.end() && resv->second.size() != 1;
+  return s.isVariable && s.var.size() != 1;
 }
 
-const vector<int> &Parser::getVector(const string &symbol, int index) const{
-  map<string, Symbol>::const_iterator res = symb.find(symbol);
-  if (res != symb.end()) {
-    if (size_t(index) < res->second.value.size())
-      return res->second.value[index];
+const vector<int> &Parser::getVector(int slot, int index) const{
+  const Slot &s = getBound(slot);
+  if (s.isSymbol) {
+    if (size_t(index) < s.symbol.value.size())
+      return s.symbol.value[index];
     else
-      throw meosException("Index out of range for X.#" + symbol);
+      throw meosException("Index out of range for X.#" + s.name);
   }
-  map<string, vector<int> >::const_iterator resv = var.find(symbol);
-  if (resv != var.end())
-    return resv->second;
+  if (s.isVariable)
+    return s.var;
+
+  throw meosException("Unknown symbol X#" + s.name);
+}
 
-  throw meosException("Unknown symbol X#" + symbol);
+Parser::Symbol &Parser::getSymbol(const char *name) {
+  return getSymbol(getSlot(name));
+}
+
+Parser::Symbol &Parser::getSymbol(int slot) {
+  Slot &s = slots[slot];
+  assert(s.isSymbol);
+  s.isSymbol = true;
+  s.symbol.deferKey = -1;
+  return s.symbol;
+}
+
+void Parser::deferSymbol(const char *name, int key) {
+  deferSymbol(getSlot(name), key);
+}
+
+void Parser::deferSymbol(int slot, int key) {
+  Symbol &s = getSymbol(slot);
+  s.deferKey = key;
 }
 
 void Parser::addSymbol(const char *name, const string &value) {
-  assert(symb.count(name) && !symb[name].isVector);
-  symb[name].value.resize(1);
-  vector<int> &v = symb[name].value[0];
+  Symbol &s = getSymbol(name);
+  assert(!s.isVector);
+  s.value.resize(1);
+  vector<int> &v = s.value[0];
   v.resize(1);
   v[0] = atoi(value.c_str());
 }
 
 void Parser::addSymbol(const char *name, int value) {
-  assert(symb.count(name) && !symb[name].isVector);
-  symb[name].value.resize(1);
-  vector<int> &v = symb[name].value[0];
+  addSymbol(getSlot(name), value);
+}
+
+void Parser::addSymbol(int slot, int value) {
+  Symbol &s = getSymbol(slot);
+  assert(!s.isVector);
+  s.value.resize(1);
+  vector<int> &v = s.value[0];
   v.resize(1);
   v[0] = value;
 }
 
 void Parser::addSymbol(const char *name, const vector<string> &value) {
-  assert(symb.count(name) && symb[name].isVector);
-  symb[name].value.resize(1);
-  vector<int> &v = symb[name].value[0];
+  Symbol &s = getSymbol(name);
+  assert(s.isVector);
+  s.value.resize(1);
+  vector<int> &v = s.value[0];
   v.resize(value.size());
   for (size_t k = 0; k < value.size(); k++)
     v[k] = atoi(value[k].c_str());
 }
 
 void Parser::addSymbol(const char *name, const vector<int> &value) {
-  assert(symb.count(name) && symb[name].isVector);
-  symb[name].value.resize(1);
-  symb[name].value[0] = value;
+  addSymbol(getSlot(name), value);
+}
+
+void Parser::addSymbol(int slot, const vector<int> &value) {
+  Symbol &s = getSymbol(slot);
+  assert(s.isVector);
+  s.value.resize(1);
+  s.value[0] = value;
 }
 
 void Parser::addSymbol(const char *name, vector< vector<int> > &value) {
-  assert(symb.count(name) && symb[name].isVector);
-  symb[name].value.swap(value);
+  addSymbol(getSlot(name), value);
+}
+
+void Parser::addSymbol(int slot, vector< vector<int> > &value) {
+  Symbol &s = getSymbol(slot);
+  assert(s.isVector);
+  s.value.swap(value);
 }
 
 void Parser::removeSymbol(const char *name) {
-  symb[name].value.clear();
+  removeSymbol(getSlot(name));
+}
+
+void Parser::removeSymbol(int slot) {
+  Slot &s = slots[slot];
+  s.isSymbol = true;
+  s.symbol.deferKey = -1;
+  s.symbol.value.clear();
 }
 
 void Parser::clearSymbols() {
-  symb.clear();
+  for (Slot &s : slots) {
+    s.isSymbol = false;
+    s.symbol = Symbol();
+  }
 }
 
 void Parser::clearVariables() const {
-  var.clear();
+  for (int slot : usedVariables) {
+    slots[slot].isVariable = false;
+    slots[slot].var.clear();
+  }
+  usedVariables.clear();
 }
 
 void Parser::takeVariable(const char*name, vector<int> &val) const {
-  map<string, vector<int> >::iterator resv = var.find(name);
-  if (resv != var.end()) {
-    vector<int> &res = resv->second;
+  int slot = findSlot(name);
+  if (slot >= 0 && slots[slot].isVariable) {
+    vector<int> &res = slots[slot].var;
     val.swap(res);
   }
   else
@@ -1355,33 +2167,35 @@ void Parser::takeVariable(const char*name, vector<int> &val) const {
 
 void Parser::getSymbols(vector< pair<wstring, size_t> > &symbOut) const {
   int iter = 0;
-  for(auto it = symb.begin(); it != symb.end(); ++it) {
-    if (it->second.deprecated)
+  for (int slot : getSortedSlots()) {
+    const Slot &s = slots[slot];
+    if (!s.isSymbol || s.symbol.deprecated)
       continue;
 
-    if (it->second.isMatrix)
-      symbOut.push_back(make_pair(gdi_main->widen(it->first) + L"[][]\t" + lang.tl(it->second.desc), iter++));
-    else if (it->second.isVector)
-      symbOut.push_back(make_pair(gdi_main->widen(it->first) + L"[]\t" + lang.tl(it->second.desc), iter++));
+    if (s.symbol.isMatrix)
+      symbOut.push_back(make_pair(gdi_main->widen(s.name) + L"[][]\t" + lang.tl(s.symbol.desc), iter++));
+    else if (s.symbol.isVector)
+      symbOut.push_back(make_pair(gdi_main->widen(s.name) + L"[]\t" + lang.tl(s.symbol.desc), iter++));
     else
-      symbOut.push_back(make_pair(gdi_main->widen(it->first) + L"\t" + lang.tl(it->second.desc), iter++));
+      symbOut.push_back(make_pair(gdi_main->widen(s.name) + L"\t" + lang.tl(s.symbol.desc), iter++));
   }
 }
 
 void Parser::getSymbolInfo(int ix, wstring &name, wstring &desc) const {
   int iter = 0;
-  for(auto it = symb.begin(); it != symb.end(); ++it) {
-    if (it->second.deprecated)
+  for (int slot : getSortedSlots()) {
+    const Slot &s = slots[slot];
+    if (!s.isSymbol || s.symbol.deprecated)
       continue;
 
     if (ix == iter++) {
-      if (it->second.isMatrix)
-        name = gdi_main->widen(it->first) + L"[][]";
-      else if (it->second.isVector)
-        name = gdi_main->widen(it->first) + L"[]";
+      if (s.symbol.isMatrix)
+        name = gdi_main->widen(s.name) + L"[][]";
+      else if (s.symbol.isVector)
+        name = gdi_main->widen(s.name) + L"[]";
       else
-        name = gdi_main->widen(it->first);
-      desc = gdi_main->widen(it->second.desc);
+        name = gdi_main->widen(s.name);
+      desc = gdi_main->widen(s.symbol.desc);
 
       return;
     }
@@ -1396,6 +2210,32 @@ static void assertEq(int a, int b) {
   }
 }
 
+/** Evaluate both the parse tree and the compiled program.*/
+static void assertEval(const Parser &parser, const ParseNode *pn, int expected) {
+  assertEq(pn->evaluate(parser), expected);
+  ParseProgram prg;
+  parser.compile(pn, prg);
+  assertEq(parser.execute(prg), expected);
+}
+
+static void assertFail(const Parser &parser, const ParseNode *pn) {
+  try {
+    pn->evaluate(parser);
+    assertEq(0,1);
+  }
+  catch (const meosException &) {
+  }
+
+  ParseProgram prg;
+  parser.compile(pn, prg);
+  try {
+    parser.execute(prg);
+    assertEq(0,1);
+  }
+  catch (const meosException &) {
+  }
+}
+
 void Parser::test() {
   Parser parser;
   vector<int> tt;
@@ -1427,136 +2267,121 @@ void Parser::test() {
   pn = parser.parse("a*b*e + c*d + f == 5*4 + 3*2; if (foo) {aa; {x;y} } rolf2=nasse; rolf2 ");
 
   pn = parser.parse("{g=1;}{h=1} {(1)} {{(h++) }} return g+h");
-  assertEq(pn->evaluate(parser), 3);
+  assertEval(parser, pn, 3);
 
   pn = parser.parse("16-8+4-2+1"); // 16-(8-4+2-1)
                                    // 16-(8-(4-2+1))
                                    // 16-(8-(4-(2-1))
-  assertEq(pn->evaluate(parser), 11);
+  assertEval(parser, pn, 11);
 
   pn = parser.parse("16-8-4-2-1)");
-  assertEq(pn->evaluate(parser), 1);
+  assertEval(parser, pn, 1);
 
   pn = parser.parse("16-8+4-2-1)");
-  assertEq(pn->evaluate(parser), 9);
+  assertEval(parser, pn, 9);
 
   pn = parser.parse("16-(8+4-2+1)");
-  assertEq(pn->evaluate(parser), 5);
+  assertEval(parser, pn, 5);
 
   pn = parser.parse("16-2*4*1+2*2*1-2*1");
-  assertEq(pn->evaluate(parser), 10);
+  assertEval(parser, pn, 10);
 
   pn = parser.parse("a = (1+2) * (3+4);b = a-2*10");
-  assertEq(pn->evaluate(parser), 1);
+  assertEval(parser, pn, 1);
 
   pn = parser.parse("1 + 2*2"); 
-  assertEq(pn->evaluate(parser), 5);
+  assertEval(parser, pn, 5);
   
   pn = parser.parse("1 + (1+1)*2"); 
-  assertEq(pn->evaluate(parser), 5);
+  assertEval(parser, pn, 5);
   
   pn = parser.parse("1 * -(1+1)*+(1+1)+10"); 
-  assertEq(pn->evaluate(parser), 6);
+  assertEval(parser, pn, 6);
 
   pn = parser.parse("3*5 + (3-1)*3*2 - 5*3"); 
-  assertEq(pn->evaluate(parser), 12);
+  assertEval(parser, pn, 12);
 
   pn = parser.parse("{a = 1; {b=2;}} if (t == a+1*b) {a++; if (a>1) {a = a*2}; return a+6;} else a--; +1+1");
-  assertEq(pn->evaluate(parser), 10);
+  assertEval(parser, pn, 10);
 
   pn = parser.parse("a = 3; if (1+1 == a) return 2; return 5*5*5-20;");
-  assertEq(pn->evaluate(parser), 105);
+  assertEval(parser, pn, 105);
 
   pn = parser.parse("max(1,2);");
-  assertEq(pn->evaluate(parser), 2);
+  assertEval(parser, pn, 2);
 
   pn = parser.parse("max(1,2) + min(max(0,1),2)");
-  assertEq(pn->evaluate(parser), 3);
+  assertEval(parser, pn, 3);
 
   pn = parser.parse("-1*-1*2+-3*3+-max(-1, 2)");
-  assertEq(pn->evaluate(parser), -9);
+  assertEval(parser, pn, -9);
 
   pn = parser.parse("1+-1+1");
-  assertEq(pn->evaluate(parser), 1);
+  assertEval(parser, pn, 1);
 
   pn = parser.parse("1+tt[1+1]");
-  assertEq(pn->evaluate(parser), 10);
+  assertEval(parser, pn, 10);
 
   pn = parser.parse("a[3] = 12; tt.size() + a.size() + a[3]");
-  assertEq(pn->evaluate(parser), 19);
+  assertEval(parser, pn, 19);
 
   pn = parser.parse("a = 2; k = 1; while(a-- > 0) { k = k*2;} return k;");
-  assertEq(pn->evaluate(parser), 4);
+  assertEval(parser, pn, 4);
 
   pn = parser.parse("a=1; while(1) {a=a*2; if (a>60) break;} return a;");
-  assertEq(pn->evaluate(parser), 64);
+  assertEval(parser, pn, 64);
 
   pn = parser.parse("res = 1; for(k = 0; k < 10; ++k) res=res*2");
-  assertEq(pn->evaluate(parser), 1024);
+  assertEval(parser, pn, 1024);
 
   pn = parser.parse("m = 1; n = 1; a = ++m + 4*n++; return a + 100*m + 1000*n");
-  assertEq(pn->evaluate(parser), 2206);
+  assertEval(parser, pn, 2206);
 
   pn = parser.parse("m = 1; n = 1; a = m++ + 4*++n; return a + 100*m + 1000*n");
-  assertEq(pn->evaluate(parser), 2209);
+  assertEval(parser, pn, 2209);
 
   pn = parser.parse("m = 2; n = 2; a = m-- + 4*--n; return a + 100*m + 1000*n");
-  assertEq(pn->evaluate(parser), 1106);
+  assertEval(parser, pn, 1106);
 
   pn = parser.parse("for(m=0; m < 10; m++) arr[m] = m * m; ret = 0; for(m = 0; m < arr.size(); m++) ret = ret + arr[m];");
-  assertEq(pn->evaluate(parser), 1+4+9+16+25+36+49+64+81);
+  assertEval(parser, pn, 1+4+9+16+25+36+49+64+81);
 
   pn = parser.parse("a = 0; if (1!=2) a = a + 1; if (1<2) a=a+2; if (1<=2) a=a+4; if (1>2) a=a+8; if (!(1==2)) a=a+16; if (1>=2) a=a+32; if (1>5 or 1+1 < 5) a=a+64; return a;");
-  assertEq(pn->evaluate(parser), 1+2+4+16+64);
+  assertEval(parser, pn, 1+2+4+16+64);
 
   pn = parser.parse("i = 3; return ttt[1][i];"); 
-  assertEq(pn->evaluate(parser), 55);
+  assertEval(parser, pn, 55);
 
   pn = parser.parse("return ttt[3][0];"); 
-  try {
-    pn->evaluate(parser);
-    assertEq(0,1);
-  }
-  catch (const meosException &) {
-  }
+  assertFail(parser, pn);
 
   pn = parser.parse("return ttt[0][5];"); 
-  try {
-    pn->evaluate(parser);
-    assertEq(0,1);
-  }
-  catch (const meosException &) {
-  }
+  assertFail(parser, pn);
 
   pn = parser.parse("return ttt[4].size();"); 
-  try {
-    pn->evaluate(parser);
-    assertEq(0,1);
-  }
-  catch (const meosException &) {
-  }
+  assertFail(parser, pn);
 
   pn = parser.parse("ttt.size()"); 
-  assertEq(pn->evaluate(parser), 2);
+  assertEval(parser, pn, 2);
 
   pn = parser.parse("sum = 0; for (k = 0; k < ttt.size(); k++) {for (m = 0; m < ttt[k].size(); m++) sum = sum + ttt[k][m];}"); 
-  assertEq(pn->evaluate(parser), 83);
+  assertEval(parser, pn, 83);
 
   pn = parser.parse("ma = tt2; ma.sort(); s = 0; for(k = 0; k < ma.size(); k++) {s = s + (k+1)*ma[k];} return s;"); 
   pn->evaluate(parser);
-  assertEq(pn->evaluate(parser), 1*1+2*2+3*3+4*4);
+  assertEval(parser, pn, 1*1+2*2+3*3+4*4);
 
   pn = parser.parse("arr = ttt[1]; s = 0; for(k = 0; k < arr.size(); k++) {s = s + arr[k];} return s;"); 
   pn->evaluate(parser);
-  assertEq(pn->evaluate(parser), 69);
+  assertEval(parser, pn, 69);
 
   pn = parser.parse("k=5; //Test\n//Info\nreturn k+1;//Return 7;"); 
   pn->evaluate(parser);
-  assertEq(pn->evaluate(parser), 6);
+  assertEval(parser, pn, 6);
 
   pn = parser.parse("if (1>2) return 10; else if (1<2) return 11; else return 5;"); 
   pn->evaluate(parser);
-  assertEq(pn->evaluate(parser), 11);
+  assertEval(parser, pn, 11);
 
   try {
     parser.parse("if (1>2) return 10; else return 11; else return 5;"); 
@@ -1572,11 +2397,52 @@ void Parser::test() {
   catch (const meosException &) {
   }
 
+  pn = parser.parse("s = 0; k = 0; while (k < 10) {k++; if (k > 5) break; s = s + k;} return s;");
+  assertEval(parser, pn, 15);
+
+  pn = parser.parse("s = 0; for (k = 0; k < 4; k++) {if (k == 2) break; s = s + 1;} return s;");
+  assertEval(parser, pn, 3);
+
+  pn = parser.parse("v = tt; v[1] = 5; w = ttt[1]; return v[1] + v.size() + w.size() + w[3];");
+  assertEval(parser, pn, 5 + 3 + 4 + 55);
+
+  pn = parser.parse("x = 0; y = 0; while (x < 5) {x++; y = y + x++;}");
+  assertEval(parser, pn, 9);
+
+  pn = parser.parse("v = ttt;");
+  assertFail(parser, pn);
+
+  pn = parser.parse("v[0] = tt;");
+  assertFail(parser, pn);
+
+  pn = parser.parse("t = 1;");
+  assertFail(parser, pn);
+
+  vector<int> col = {5, -2, 7, 0};
+  vector<Column> columns = {{"t", nullptr}, {"c", col.data()}};
+  parser.declareSymbol("c", "", false);
+  int res[4];
+  pn = parser.parse("return max(c*t - 1, 2) + (c == 0);");
+  ParseProgram prg;
+  parser.compile(pn, prg);
+  assertEq(parser.isColumnProgram(prg, columns), true);
+  parser.executeColumns(prg, columns, 4, res);
+  for (int k = 0; k < 4; k++) {
+    parser.addSymbol("c", col[k]);
+    assertEq(res[k], parser.execute(prg));
+  }
+
+  pn = parser.parse("if (c > 0) return c; return t;");
+  parser.compile(pn, prg);
+  assertEq(parser.isColumnProgram(prg, columns), false);
+
 }
 
 void Parser::dumpVariables(gdioutput &gdi, int c1, int c2) const {
-  for (map<string, vector<int> >::iterator it = var.begin(); it != var.end(); ++it) {
-    const vector<int> &v = it->second;
+  for (int slot : getSortedSlots()) {
+    if (!slots[slot].isVariable)
+      continue;
+    const vector<int> &v = slots[slot].var;
     string val;
     if (v.size() == 1) {
       val = itos(v[0]);
@@ -1591,19 +2457,21 @@ void Parser::dumpVariables(gdioutput &gdi, int c1, int c2) const {
       val += "]";
     }
     int cy = gdi.getCY();
-    gdi.addStringUT(cy, c1, monoText, it->first, c2-c1-10);
+    gdi.addStringUT(cy, c1, monoText, slots[slot].name, c2-c1-10);
     gdi.addStringUT(cy, c2, monoText, val);
   }
 }
 
 void Parser::dumpSymbols(gdioutput &gdi, int c1, int c2) const {
-  for (map<string, Symbol>::const_iterator it = symb.begin(); it != symb.end(); ++it) {
-    const vector< vector<int> > &v = it->second.value;
+  for (int slot : getSortedSlots()) {
+    if (!slots[slot].isSymbol)
+      continue;
+    const vector< vector<int> > &v = getBound(slot).symbol.value;
     if (v.empty())
       continue;
 
     int cy = gdi.getCY();
-    gdi.addStringUT(cy, c1,  monoText, it->first, c2-c1-10);
+    gdi.addStringUT(cy, c1,  monoText, slots[slot].name, c2-c1-10);
 
     string val;
 
@@ -23,13 +23,15 @@
 ************************************************************************/
 
 #include <map>
+#include <unordered_map>
 #include <string>
 #include <vector>
+#include <functional>
 
 using namespace std;
 
 class Parser;
-
+class ParseProgram;
 
 class ParseNode {
 public:
@@ -37,10 +39,103 @@ public:
   virtual int evaluate(const Parser &parser) const = 0;
   virtual void assign(const Parser &parser, int value) const;
   virtual void assignVector(const Parser &parser, const vector<int> &value) const;
- 
+
+  /** Emit code that pushes the value of the node.*/
+  virtual void compile(ParseProgram &prg) const = 0;
+  /** Emit code that assigns the value on top of the stack, leaving it there.*/
+  virtual void compileAssign(ParseProgram &prg) const;
+  /** Emit code that assigns the row (on top of the stack) of the array in slot source.*/
+  virtual void compileAssignVector(ParseProgram &prg, int source) const;
+
   virtual ~ParseNode() = 0;
 };
 
+/** A parsed script compiled to code for a stack machine, see Parser::execute. Symbols and
+    variables are referred to by slot index in the parser, which must outlive the program.*/
+class ParseProgram {
+public:
+  enum OpCode {
+    CPush,        // Push a
+    CPop,
+    CDup,
+    CLoad,        // Push scalar in slot a
+    CLoadAt,      // Pop i, push slot a [i]
+    CLoadAt2,     // Pop j, pop i, push slot a [j][i]
+    CStore,       // Store top in slot a
+    CStoreAt,     // Pop i, store top in slot a [i]
+    CCheckZero,   // Pop j, which must be zero (second index of assigned slot a)
+    CStoreVector, // Pop row, assign row of array in slot b to slot a
+    CLoadSingle,  // Pop row, push the single value of row of array in slot a (assigned to slot b)
+    CTestVector,  // Jump to b unless slot a is a vector. Matrix is an error.
+    CTestMatrix,  // Jump to b unless slot a is a matrix
+    CSize,
+    CSizeBase,
+    CSizeSub,     // Pop i, push size of row i in slot a
+    CSort,
+
+    CAdd,
+    CSub,
+    CMul,
+    CDiv,
+    CMod,
+    CEquals,
+    CNotEquals,
+    CLess,
+    CLessEquals,
+    CMore,
+    CMoreEquals,
+    CMax,
+    CMin,
+    CNeg,
+    CNot,
+    CBool,
+
+    CJump,
+    CJumpIfZero,    // Pop value
+    CJumpIfNotZero, // Pop value
+    CInitTemp,      // Set temporary a to b
+    CSetTemp,       // Pop to temporary a
+    CGetTemp,       // Push temporary a
+    CSetRet,        // Pop to temporary a unless value is ignored
+    CClearIgnore,
+    CIgnore,        // Ignore value, push -1
+    CIgnoreIfZero,  // Ignore value if temporary a is zero
+    CClearBreak,
+    CJumpIfBreak,
+    CBreakLoop,     // End loop (jump to a) on break
+    CBreak,
+    CLoopCount,     // Count down temporary a, stalled loop (b=0: while, b=1: for) when zero
+    CReturn,
+    CNullStatement,
+    CIllegalAssignment,
+  };
+
+  struct Instruction {
+    OpCode op;
+    int a;
+    int b;
+  };
+
+  int emit(OpCode op, int a = 0, int b = 0) {
+    code.push_back({op, a, b});
+    return code.size() - 1;
+  }
+
+  /** Index of the next instruction.*/
+  int label() const {return code.size();}
+  /** Set jump target of an emitted jump instruction.*/
+  void setTarget(int ix, int target);
+  int getTemporary() {return numTemporary++;}
+
+  bool empty() const {return code.empty();}
+  void clear();
+
+private:
+  vector<Instruction> code;
+  int numTemporary = 0;
+  friend class Parser;
+};
+
 
 class Parser {
   enum Operator {
@@ -101,15 +196,45 @@ class Parser {
     bool isVector;
     bool isMatrix;
     bool deprecated = false;
+    // Key passed to the symbol provider when the value is needed, -1 if bound
+    int deferKey = -1;
     vector<vector<int>> value;
   };
 
-  map<string, Symbol> symb;
-  mutable map<string, vector<int>> var;
+  struct Slot {
+    string name;
+    bool isSymbol = false;
+    Symbol symbol;
+    bool isVariable = false;
+    vector<int> var;
+  };
 
-  mutable int breakMode;
-  mutable bool returnMode;
-  mutable bool ignoreValue;
+  // Symbols and variables by slot, bound when parsing. Slots are never removed,
+  // so slot indices in parsed nodes and compiled programs remain valid.
+  mutable vector<Slot> slots;
+  unordered_map<string, int> slotIndex;
+  mutable vector<int> usedVariables;
+
+  int getSlot(const string &name);
+  int findSlot(const string &name) const;
+  Symbol &getSymbol(const char *name);
+  Symbol &getSymbol(int slot);
+
+  function<void(int key)> symbolProvider;
+  void bindDeferred(int slot) const;
+  const Slot &getBound(int slot) const {
+    if (slots[slot].symbol.deferKey >= 0)
+      bindDeferred(slot);
+    return slots[slot];
+  }
+  vector<int> getSortedSlots() const;
+
+  mutable int breakMode = 0;
+  mutable bool returnMode = false;
+  mutable bool ignoreValue = false;
+
+  mutable vector<int> stack;
+  mutable vector<int> temporary;
 
   ParseNode *parseStatement(const string &expr, bool primary);
   ParseNode *parseStatement(ParseNode *left, const string &expr, size_t &pos, int level, bool changeSign);
@@ -123,6 +248,7 @@ class Parser {
 
   public:
     int evaluate(const Parser &parser) const;
+    void compile(ParseProgram &prg) const;
 
     StatementNode();
     virtual ~StatementNode();
@@ -131,6 +257,9 @@ class Parser {
 
   class ValueNode : public ParseNode {
     string value;
+    int slot = -1;
+    bool literal = false;
+    int constant = 0;
     ValueNode(const ValueNode&) = delete;
     ValueNode &operator=(const ValueNode &) = delete;
 
@@ -139,7 +268,11 @@ class Parser {
     bool isVariable() const;
     void assign(const Parser &parser, int value) const;
     void assignVector(const Parser &parser, const vector<int> &value) const;
- 
+
+    void compile(ParseProgram &prg) const;
+    void compileAssign(ParseProgram &prg) const;
+    void compileAssignVector(ParseProgram &prg, int source) const;
+
     ValueNode();
     virtual ~ValueNode();
     friend class Parser;
@@ -147,6 +280,7 @@ class Parser {
 
   class ArrayValueNode : public ParseNode {
     string expr;
+    int slot = -1;
     ParseNode *index;
     ParseNode *index2;    
     ArrayValueNode(const ArrayValueNode&) = delete;
@@ -156,7 +290,11 @@ class Parser {
     int evaluate(const Parser &parser) const;
     void assign(const Parser &parser, int value) const;
     void assignVector(const Parser &parser, const vector<int> &value) const;
- 
+
+    void compile(ParseProgram &prg) const;
+    void compileAssign(ParseProgram &prg) const;
+    void compileAssignVector(ParseProgram &prg, int source) const;
+
     bool isVariable() const;
     ArrayValueNode();
     virtual ~ArrayValueNode();
@@ -173,6 +311,7 @@ class Parser {
 
   public:
     int evaluate(const Parser &parser) const;
+    void compile(ParseProgram &prg) const;
 
     UnaryOperatorNode();
     virtual ~UnaryOperatorNode();
@@ -188,6 +327,7 @@ class Parser {
 
   public:
     int evaluate(const Parser &parser) const;
+    void compile(ParseProgram &prg) const;
 
     BinaryOperatorNode();
     virtual ~BinaryOperatorNode();
@@ -203,6 +343,7 @@ class Parser {
 
   public:
     int evaluate(const Parser &parser) const;
+    void compile(ParseProgram &prg) const;
 
     IfNode();
     virtual ~IfNode();
@@ -217,6 +358,7 @@ class Parser {
 
   public:
     int evaluate(const Parser &parser) const;
+    void compile(ParseProgram &prg) const;
 
     WhileNode();
     virtual ~WhileNode();
@@ -235,6 +377,7 @@ class Parser {
 
   public:
     int evaluate(const Parser &parser) const;
+    void compile(ParseProgram &prg) const;
 
     ForNode();
     virtual ~ForNode();
@@ -242,20 +385,19 @@ class Parser {
   };
 
 
-  int evaluate(const string &input) const;
-  int evaluate(const string &input, int index, int index2) const;
-  int evaluateSize(const string &input, int index) const;
-  void sortArray(const string &input) const;
+  int evaluate(int slot) const;
+  int evaluate(int slot, int index, int index2) const;
+  int evaluateSize(int slot, int index) const;
+  void sortArray(int slot) const;
 
-  
-  void storeVariable(const string &input, const vector<int> &value) const;
-  void storeVariable(const string &input, int value) const;
-  void storeVariable(const string &input, int index, int value) const;
+  void storeVariable(int slot, const vector<int> &value) const;
+  void storeVariable(int slot, int value) const;
+  void storeVariable(int slot, int index, int value) const;
 
   UnaryOperatorNode *getUnary();
   BinaryOperatorNode *getBinary();
-  ValueNode *getValue();
-  ArrayValueNode *getArrayValue();
+  ValueNode *getValue(const string &word);
+  ArrayValueNode *getArrayValue(const string &word);
   StatementNode *getStatement();
   IfNode *getif ();
   WhileNode *getWhile();
@@ -270,12 +412,36 @@ class Parser {
   string parseMethod(const string &expr, size_t &pos);
 
   vector<ParseNode *> nodes;
-  bool isMatrix(const string &symbol) const;
-  bool isVector(const string &symbol) const;
+  bool isMatrix(int slot) const;
+  bool isVector(int slot) const;
+
+  const vector<int> &getVector(int slot, int index) const;
+public:
+  /** Input of a batch evaluation: a scalar symbol with one value per row. A symbol
+      without values has its bound value on all rows.*/
+  struct Column {
+    const char *symbol;
+    const int *values;
+  };
+
+private:
+  // Max stack depth of a column program, 0 if the program cannot run over columns
+  int getColumnStackSize(const ParseProgram &prg, const vector<Column> &columns, vector<const int *> &slotValues) const;
 
-  const vector<int> &getVector(const string &symbol, int index) const;
 public:
   ParseNode *parse(const string &expr);
+
+  /** Compile a parsed script. The tree is kept as the reference for the program.*/
+  void compile(const ParseNode *pn, ParseProgram &prg) const;
+  /** Run a compiled script. Gives the same result as evaluating the parsed script.*/
+  int execute(const ParseProgram &prg) const;
+
+  /** True if the compiled script is a single expression of scalar symbols in columns,
+      which can be evaluated for many rows at once.*/
+  bool isColumnProgram(const ParseProgram &prg, const vector<Column> &columns) const;
+  /** Evaluate a column program for each row. Does not modify the parser. */
+  void executeColumns(const ParseProgram &prg, const vector<Column> &columns, int rows, int *result) const;
+
   static void test();
 
   Parser();
@@ -287,6 +453,19 @@ public:
   void addSymbol(const char *name, const vector<int> &value);
   void addSymbol(const char *name, vector< vector<int> > &value);
   void removeSymbol(const char *name);
+  /** Compute the value of a declared symbol first when it is read. The symbol provider
+      is then called with the key, and must add the symbol.*/
+  void deferSymbol(const char *name, int key);
+
+  /** Slot of a symbol. Use with the overloads below to set symbols
+      repeatedly without looking up the name.*/
+  int getSymbolSlot(const char *name) { return getSlot(name); }
+  void addSymbol(int slot, int value);
+  void addSymbol(int slot, const vector<int> &value);
+  void addSymbol(int slot, vector< vector<int> > &value);
+  void removeSymbol(int slot);
+  void deferSymbol(int slot, int key);
+  void setSymbolProvider(const function<void(int key)> &provider) {symbolProvider = provider;}
   void declareSymbol(const char *name, const string &desc, bool isVector, bool isMatrix = false, bool deprecated = false);
   void clearSymbols();
   void clearVariables() const;
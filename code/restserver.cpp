@@ -41,6 +41,7 @@ Eksoppsvägen 16, SE-75646 UPPSALA, Sweden
 #include "RunnerDB.h"
 #include "image.h"
 #include "cardsystem.h"
+#include "minizip/zlib.h"
 #include <tuple>
 
 extern Image image;
@@ -93,6 +94,206 @@ static void method_handler(const shared_ptr< restbed::Session > session) {
   server.handleRequest(session);
 }
 
+namespace {
+  enum class ContentEncoding {
+    Identity,
+    GZip,
+    Deflate
+  };
+
+  // Answers smaller than this are not compressed
+  const size_t minCompressSize = 1024;
+  // Answers larger than this are sent in chunks
+  const size_t chunkedSize = 256 * 1024;
+  const size_t chunkSize = 64 * 1024;
+
+  /** Select gzip or deflate if accepted by the client.*/
+  ContentEncoding getContentEncoding(const string &acceptEncoding) {
+    bool gzip = false, deflate = false;
+    vector<string> codings;
+    split(acceptEncoding, ",", codings);
+    for (string &c : codings) {
+      size_t q = c.find(';');
+      string name = trim(c.substr(0, q));
+      if (q != string::npos) {
+        size_t qv = c.find("q=", q);
+        if (qv != string::npos && atof(c.c_str() + qv + 2) <= 0)
+          continue;
+      }
+      if (_stricmp(name.c_str(), "gzip") == 0)
+        gzip = true;
+      else if (_stricmp(name.c_str(), "deflate") == 0)
+        deflate = true;
+    }
+
+    if (gzip)
+      return ContentEncoding::GZip;
+    else if (deflate)
+      return ContentEncoding::Deflate;
+    return ContentEncoding::Identity;
+  }
+
+  /** The ETag of an answer sent with the given encoding. Each encoding is a different representation.*/
+  string getEncodedETag(const string &etag, ContentEncoding encoding) {
+    if (etag.size() < 2 || encoding == ContentEncoding::Identity)
+      return etag;
+    // The suffix goes inside the quotes
+    string encoded = etag.substr(0, etag.size() - 1);
+    encoded += encoding == ContentEncoding::GZip ? "-gzip\"" : "-deflate\"";
+    return encoded;
+  }
+
+  /** True if an If-None-Match header (a list of tags or *) matches the ETag.*/
+  bool matchETag(const string &ifNoneMatch, const string &etag) {
+    if (etag.empty() || ifNoneMatch.empty())
+      return false;
+
+    vector<string> tags;
+    split(ifNoneMatch, ",", tags);
+    for (string &t : tags) {
+      string tag = trim(t);
+      if (tag == "*")
+        return true;
+      // If-None-Match uses weak comparison
+      if (tag.compare(0, 2, "W/") == 0)
+        tag = tag.substr(2);
+      if (tag == etag)
+        return true;
+    }
+    return false;
+  }
+
+  bool useKeepAlive(const shared_ptr<const restbed::Request> &request) {
+    string connection = request->get_header("Connection", "");
+    if (request->get_version() >= 1.1)
+      return _stricmp(connection.c_str(), "close") != 0;
+    else
+      return _stricmp(connection.c_str(), "keep-alive") == 0;
+  }
+
+  /** Incremental gzip or deflate (zlib) compression.*/
+  class Compressor {
+    z_stream stream;
+  public:
+    Compressor(ContentEncoding encoding) {
+      memset(&stream, 0, sizeof(stream));
+      // Fast compression, since it is done for every request
+      int windowBits = encoding == ContentEncoding::GZip ? 15 + 16 : 15;
+      if (deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        throw std::exception("Compression failed");
+    }
+
+    ~Compressor() {
+      deflateEnd(&stream);
+    }
+
+    Compressor(const Compressor &) = delete;
+    Compressor &operator=(const Compressor &) = delete;
+
+    /** Compress and append the result to out. Set finish for the last block.*/
+    void compress(const char *data, size_t size, bool finish, string &out) {
+      stream.next_in = (Bytef *)data;
+      stream.avail_in = uInt(size);
+      char buffer[16 * 1024];
+      int res;
+      do {
+        stream.next_out = (Bytef *)buffer;
+        stream.avail_out = sizeof(buffer);
+        res = deflate(&stream, finish ? Z_FINISH : Z_NO_FLUSH);
+        if (res == Z_STREAM_ERROR)
+          throw std::exception("Compression failed");
+        out.append(buffer, sizeof(buffer) - stream.avail_out);
+      } while (stream.avail_out == 0 || (finish && res != Z_STREAM_END));
+    }
+  };
+
+  /** State of an answer sent in chunks. The answer is built in full before sending;
+      only compression and transfer are incremental.*/
+  struct ChunkedAnswer {
+    string data;
+    size_t pos = 0;
+    unique_ptr<Compressor> compressor;
+    bool keepAlive = false;
+  };
+
+  void writeNextChunk(const shared_ptr<Session> &session, const shared_ptr<ChunkedAnswer> &state) {
+    string chunk;
+    bool last;
+    do {
+      size_t len = min(chunkSize, state->data.size() - state->pos);
+      last = state->pos + len == state->data.size();
+      if (state->compressor)
+        state->compressor->compress(state->data.c_str() + state->pos, len, last, chunk);
+      else
+        chunk.append(state->data, state->pos, len);
+      state->pos += len;
+    } while (chunk.empty() && !last);
+
+    char bf[16];
+    sprintf_s(bf, "%zx\r\n", chunk.size());
+    string out;
+    out.reserve(chunk.size() + 32);
+    if (!chunk.empty()) {
+      out += bf;
+      out += chunk;
+      out += "\r\n";
+    }
+
+    if (!last) {
+      session->yield(out, [state](const shared_ptr<Session> session) {
+        writeNextChunk(session, state);
+      });
+    }
+    else {
+      out += "0\r\n\r\n";
+      if (state->keepAlive)
+        session->yield(out); // Wait for the next request on the connection
+      else
+        session->close(out);
+    }
+  }
+
+  /** Send an answer, compressed if accepted by the client and in chunks if large.*/
+  void sendAnswer(const shared_ptr<Session> &session, string &&answer,
+                  multimap<string, string> &&headers, ContentEncoding encoding, bool keepAlive) {
+    headers.emplace("Connection", keepAlive ? "keep-alive" : "close");
+    headers.emplace("Access-Control-Allow-Origin", "*");
+    headers.emplace("Vary", "Accept-Encoding");
+
+    if (answer.size() < minCompressSize)
+      encoding = ContentEncoding::Identity;
+
+    if (encoding != ContentEncoding::Identity)
+      headers.emplace("Content-Encoding", encoding == ContentEncoding::GZip ? "gzip" : "deflate");
+
+    if (answer.size() > chunkedSize) {
+      auto state = make_shared<ChunkedAnswer>();
+      state->data = std::move(answer);
+      state->keepAlive = keepAlive;
+      if (encoding != ContentEncoding::Identity)
+        state->compressor = make_unique<Compressor>(encoding);
+
+      headers.emplace("Transfer-Encoding", "chunked");
+      session->yield(restbed::OK, headers, [state](const shared_ptr<Session> session) {
+        writeNextChunk(session, state);
+      });
+      return;
+    }
+
+    if (encoding != ContentEncoding::Identity) {
+      string compressed;
+      Compressor(encoding).compress(answer.c_str(), answer.size(), true, compressed);
+      answer.swap(compressed);
+    }
+
+    headers.emplace("Content-Length", itos(answer.size()));
+    if (keepAlive)
+      session->yield(restbed::OK, answer, headers);
+    else
+      session->close(restbed::OK, answer, headers);
+  }
+}
+
 void RestServer::handleRequest(const shared_ptr<restbed::Session> &session) {
   const auto request = session->get_request();
   string path = request->get_path();
@@ -107,30 +308,81 @@ void RestServer::handleRequest(const shared_ptr<restbed::Session> &session) {
     param = rootMap;
   }
 
-  auto answer = RestServer::addRequest(param);
+  string endpoint = getEndpoint(param);
+  string ifNoneMatch = request->get_header("If-None-Match", "");
+  ContentEncoding encoding = getContentEncoding(request->get_header("Accept-Encoding", ""));
+  bool keepAlive = useKeepAlive(request);
+
+  shared_ptr<EventRequest> answer;
+  auto snapshotAnswer = getSnapshotAnswer(param);
+  if (snapshotAnswer) {
+    // Answered on this thread without involving the event
+    answer = make_shared<EventRequest>();
+    answer->answer = snapshotAnswer->answer;
+    answer->etag = snapshotAnswer->etag;
+    answer->fromCache = true;
+    answer->state = true;
+  }
+  else {
+    answer = RestServer::addRequest(param);
+  }
+
+  bool notModified = false;
+  string etag;
   {
     unique_lock<mutex> mlock(lock);
     if (!waitForCompletion.wait_for(mlock, 10s, [answer] {return answer->isCompleted(); })) {
       answer->answer = "Error (MeOS): Internal timeout";
-    }
+      answer->etag.clear();
+    }
+
+    // Small answers are never compressed, see sendAnswer
+    if (answer->answer.size() < minCompressSize)
+      encoding = ContentEncoding::Identity;
+    etag = getEncodedETag(answer->etag, encoding);
+    notModified = matchETag(ifNoneMatch, etag);
+    EndpointCounter &cnt = endpointCounters[endpoint];
+    if (notModified)
+      cnt.notModified++;
+    else if (answer->fromCache)
+      cnt.hits++;
+    else
+      cnt.misses++;
 
     end = chrono::system_clock::now();
     chrono::duration<double> elapsed_seconds = end - start;
     responseTimes.push_back(int(1000 * elapsed_seconds.count()));
   }
 
-  session->fetch(content_length, [request, answer](const shared_ptr< Session > session, const Bytes & body)
+  session->fetch(content_length, [request, answer, etag, notModified, encoding, keepAlive](const shared_ptr< Session > session, const Bytes & body)
   {
-    if (answer->image.empty()) {
-      session->close(restbed::OK, answer->answer, { { "Content-Length", itos(answer->answer.length()) },
-                                                    { "Connection", "close" },
-                                                    { "Access-Control-Allow-Origin", "*" } });
+    const char *connection = keepAlive ? "keep-alive" : "close";
+    if (notModified) {
+      multimap<string, string> headers = { { "ETag", etag },
+                                           { "Vary", "Accept-Encoding" },
+                                           { "Content-Length", "0" },
+                                           { "Connection", connection },
+                                           { "Access-Control-Allow-Origin", "*" } };
+      if (keepAlive)
+        session->yield(restbed::NOT_MODIFIED, headers);
+      else
+        session->close(restbed::NOT_MODIFIED, headers);
+    }
+    else if (answer->image.empty()) {
+      multimap<string, string> headers;
+      if (!etag.empty())
+        headers.emplace("ETag", etag);
+      sendAnswer(session, std::move(answer->answer), std::move(headers), encoding, keepAlive);
     }
     else {
-      session->close(restbed::OK, answer->image, { { "Content-Type", "image/png"},
-                                                   { "Content-Length", itos(answer->image.size()) },
-                                                   { "Connection", "close" },
-                                                   { "Access-Control-Allow-Origin", "*" } });
+      multimap<string, string> headers = { { "Content-Type", "image/png"},
+                                           { "Content-Length", itos(answer->image.size()) },
+                                           { "Connection", connection },
+                                           { "Access-Control-Allow-Origin", "*" } };
+      if (keepAlive)
+        session->yield(restbed::OK, answer->image, headers);
+      else
+        session->close(restbed::OK, answer->image, headers);
     }
   });
 }
@@ -138,6 +390,9 @@ void RestServer::handleRequest(const shared_ptr<restbed::Session> &session) {
 void RestServer::startThread(int port) {
   auto settings = make_shared<Settings>();
   settings->set_port(port);
+  // Several workers, so that read-only requests answered from the
+  // snapshot are not blocked by requests waiting for the main thread.
+  settings->set_worker_limit(max(4u, std::thread::hardware_concurrency()));
   auto resource = make_shared<MeOSResource>(this);
   resource->set_path("/meos");
   
@@ -194,12 +449,50 @@ void RestServer::computeRequested(oEvent &ref) {
 }
 
 void RestServer::compute(oEvent &ref) {
-  auto rq = getRequest();
-  if (!rq)
-    return;
+  if (ref.isClient())
+    synchronizeWithServer(ref);
 
+  {
+    // Never answer from a snapshot of old data
+    lock_guard<mutex> lg(snapshotLock);
+    if (snapshot && !snapshot->isCurrent(ref))
+      snapshot.reset();
+  }
+  updateSnapshot(ref);
+
+  while (auto rq = getRequest()) {
+    string key;
+    if (isCacheable(rq->parameters)) {
+      key = getQueryKey(rq->parameters);
+      auto res = responseCache.find(key);
+      if (res != responseCache.end() && res->second->isCurrent(ref)) {
+        rq->answer = res->second->answer;
+        rq->etag = res->second->etag;
+        rq->fromCache = true;
+      }
+    }
+
+    if (!rq->fromCache && computeRequest(ref, rq) && !key.empty()) {
+      auto cached = makeCachedAnswer(ref, std::move(rq->answer));
+      rq->answer = cached->answer;
+      rq->etag = cached->etag;
+      addToResponseCache(key, cached);
+      if (isReadOnly(rq->parameters))
+        addToSnapshot(ref, key, cached);
+    }
+
+    {
+      lock_guard<mutex> lg(lock);
+      rq->state = true;
+    }
+    waitForCompletion.notify_all();
+  }
+}
+
+bool RestServer::computeRequest(oEvent &ref, shared_ptr<EventRequest> &rq) {
   try {
     computeInternal(ref, rq);
+    return true;
   }
   catch (meosException &ex) {
     rq->answer = "Error (MeOS): Error: " + ref.gdiBase().toUTF8(lang.tl(ex.wwhat()));
@@ -210,12 +503,227 @@ void RestServer::compute(oEvent &ref) {
   catch (...) {
     rq->answer = "Error (MeOS): Unknown internal error.";
   }
+  return false;
+}
+
+namespace {
+  // Minimal time between rebuilding two snapshot answers (ms)
+  const uint64_t snapshotInterval = 100;
+  // A query not asked for this long (ms) is no longer kept up to date
+  const uint64_t activeQueryTimeout = 60 * 1000;
+  // Number of queries kept up to date
+  const size_t maxActiveQueries = 64;
+  // Minimal time between two checks for server changes when only the snapshot is used (ms)
+  const uint64_t serverCheckInterval = 1000;
+}
+
+bool RestServer::Snapshot::isCurrent(const oEvent &oe) const {
+  return revision == oe.getRevision() && nameId == oe.getNameId();
+}
+
+bool RestServer::CachedAnswer::isCurrent(const oEvent &oe) const {
+  return revision == oe.getRevision() && nameId == oe.getNameId();
+}
+
+shared_ptr<const RestServer::CachedAnswer> RestServer::makeCachedAnswer(const oEvent &ref, string &&answer) {
+  auto res = make_shared<CachedAnswer>();
+  res->nameId = ref.getNameId();
+  res->revision = ref.getRevision();
+  res->answer = std::move(answer);
+
+  // FNV-1a hash of the answer
+  uint64_t h = 14695981039346656037ull;
+  for (char c : res->answer) {
+    h ^= uint8_t(c);
+    h *= 1099511628211ull;
+  }
+  char bf[24];
+  sprintf_s(bf, "\"%016llx\"", h);
+  res->etag = bf;
+  return res;
+}
+
+void RestServer::addToResponseCache(const string &key, const shared_ptr<const CachedAnswer> &answer) {
+  const size_t maxCachedResponses = 256;
+  if (responseCache.size() >= maxCachedResponses) {
+    // Remove answers from older revisions
+    for (auto it = responseCache.begin(); it != responseCache.end();) {
+      if (it->second->revision != answer->revision || it->second->nameId != answer->nameId)
+        it = responseCache.erase(it);
+      else
+        ++it;
+    }
+    if (responseCache.size() >= maxCachedResponses)
+      responseCache.clear();
+  }
+  responseCache[key] = answer;
+}
+
+bool RestServer::isCacheable(const multimap<string, string> &param) {
+  if (isReadOnly(param) || param.count("html") > 0)
+    return true;
+
+  auto what = param.find("get");
+  return what != param.end() && (what->second == "iofresult" || what->second == "iofstart");
+}
+
+string RestServer::getEndpoint(const multimap<string, string> &param) {
+  // Only known endpoints are counted by name, so that the client cannot grow the statistics
+  static const set<string> knownGet = { "iofresult", "iofstart", "competition", "class", "organization",
+                                        "competitor", "team", "control", "result", "status", "entryclass" };
+  static const vector<string> knownKeys = { "html", "entry", "lookup", "difference",
+                                            "resultevents", "page", "enter", "image" };
+  if (param.empty())
+    return "/";
+
+  auto what = param.find("get");
+  if (what != param.end() && param.count("entry") == 0)
+    return knownGet.count(what->second) ? what->second : "other";
+
+  for (const string &key : knownKeys) {
+    if (param.count(key) > 0)
+      return key;
+  }
+  return "other";
+}
+
+bool RestServer::isReadOnly(const multimap<string, string> &param) {
+  auto what = param.find("get");
+  if (what == param.end() || param.count("entry") > 0)
+    return false;
+
+  static const set<string> readOnly = { "competition", "class", "organization", "competitor",
+                                        "team", "control", "result", "status" };
+  return readOnly.count(what->second) > 0;
+}
+
+string RestServer::getQueryKey(const multimap<string, string> &param) {
+  // The parameters are ordered by name
+  string key;
+  for (auto &p : param) {
+    if (!key.empty())
+      key += '&';
+    key += p.first;
+    key += '=';
+    key += p.second;
+  }
+  return key;
+}
 
+shared_ptr<const RestServer::CachedAnswer> RestServer::getSnapshotAnswer(const multimap<string, string> &param) {
+  if (!isReadOnly(param))
+    return nullptr;
+
+  string key = getQueryKey(param);
+  lock_guard<mutex> lg(snapshotLock);
+  auto res = activeQueries.find(key);
+  if (res == activeQueries.end()) {
+    if (activeQueries.size() >= maxActiveQueries) {
+      auto oldest = activeQueries.begin();
+      for (auto it = activeQueries.begin(); it != activeQueries.end(); ++it) {
+        if (it->second.lastRequest < oldest->second.lastRequest)
+          oldest = it;
+      }
+      activeQueries.erase(oldest);
+    }
+    res = activeQueries.emplace(key, ActiveQuery()).first;
+    res->second.parameters = param;
+  }
+  res->second.lastRequest = GetTickCount64();
+
+  if (snapshot) {
+    auto it = snapshot->answers.find(key);
+    if (it != snapshot->answers.end())
+      return it->second;
+  }
+  return nullptr;
+}
+
+void RestServer::addToSnapshot(oEvent &ref, const string &key, const shared_ptr<const CachedAnswer> &answer) {
+  lock_guard<mutex> lg(snapshotLock);
+  auto query = activeQueries.find(key);
+  if (query == activeQueries.end())
+    return;
+
+  shared_ptr<Snapshot> s;
+  if (snapshot && snapshot->isCurrent(ref))
+    s = make_shared<Snapshot>(*snapshot);
+  else if (answer->isCurrent(ref)) {
+    s = make_shared<Snapshot>();
+    s->revision = answer->revision;
+    s->nameId = answer->nameId;
+  }
+  else
+    return;
+
+  s->answers[key] = answer;
+  snapshot = s;
+  query->second.lastBuilt = GetTickCount64();
+}
+
+void RestServer::updateSnapshot(oEvent &ref) {
+  // Rebuild at most one answer per call, so that the work is spread over
+  // several iterations of the message loop. Only queries asked again since
+  // their answer was built are rebuilt; other queries are computed when asked.
+  string key;
+  auto rq = make_shared<EventRequest>();
+  uint64_t now = GetTickCount64();
   {
-    lock_guard<mutex> lg(lock);
-    rq->state = true;
+    lock_guard<mutex> lg(snapshotLock);
+    if (activeQueries.empty() || now < lastSnapshotUpdate + snapshotInterval)
+      return;
+
+    for (auto it = activeQueries.begin(); it != activeQueries.end();) {
+      if (now > it->second.lastRequest + activeQueryTimeout) {
+        it = activeQueries.erase(it);
+        continue;
+      }
+      if (key.empty() && it->second.lastRequest > it->second.lastBuilt &&
+          !(snapshot && snapshot->answers.count(it->first))) {
+        key = it->first;
+        rq->parameters = it->second.parameters;
+      }
+      ++it;
+    }
+  }
+
+  if (key.empty())
+    return;
+
+  lastSnapshotUpdate = now;
+  auto res = responseCache.find(key);
+  if (res != responseCache.end() && res->second->isCurrent(ref))
+    addToSnapshot(ref, key, res->second);
+  else if (computeRequest(ref, rq)) {
+    auto cached = makeCachedAnswer(ref, std::move(rq->answer));
+    addToResponseCache(key, cached);
+    addToSnapshot(ref, key, cached);
+  }
+  else {
+    // Do not retry a failing query until it is asked again
+    lock_guard<mutex> lg(snapshotLock);
+    auto query = activeQueries.find(key);
+    if (query != activeQueries.end())
+      query->second.lastBuilt = now;
+  }
+}
+
+void RestServer::synchronizeWithServer(oEvent &ref) {
+  // Cached answers are trusted while the revision is unchanged, but as a client the
+  // revision changes only when changes are read from the server. Check for changes
+  // (a single query if nothing changed) before answering queued requests, and
+  // periodically while the snapshot is used.
+  uint64_t now = GetTickCount64();
+  bool check = hasAnyRequest;
+  if (!check && now >= lastServerCheck + serverCheckInterval) {
+    lock_guard<mutex> lg(snapshotLock);
+    check = !activeQueries.empty();
+  }
+
+  if (check) {
+    lastServerCheck = now;
+    ref.autoSynchronizeLists(true);
   }
-  waitForCompletion.notify_all();
 }
 
 extern wchar_t programPath[MAX_PATH];
@@ -393,6 +901,11 @@ void RestServer::computeInternal(oEvent &ref, shared_ptr<RestServer::EventReques
 
     difference(ref, id, rq->answer);
   }
+  else if (rq->parameters.count("resultevents")) {
+    string what = rq->parameters.find("resultevents")->second;
+    int serial = what == "zero" ? 0 : atoi(what.c_str());
+    resultEvents(ref, serial, rq->answer);
+  }
   else if (rq->parameters.count("page") > 0) {
     string what = rq->parameters.find("page")->second;
     auto& writer = HTMLWriter::getWriter(HTMLWriter::TemplateType::Page, what, {});
@@ -537,38 +1050,32 @@ void RestServer::getData(oEvent &oe, const string &what, const multimap<string,
   out.setComplete(true);
   bool okRequest = false;
   if (what == "iofresult") {
-    wstring exportFile = getTempFile();
     bool useUTC = false;
     set<int> cls;
     if (param.count("class") > 0)
       getSelection(param.find("class")->second, cls);
     tuple<string, string, bool> preferredIdTypes("", "", true);
 
-    oe.exportIOFSplits(oEvent::IOF30, exportFile.c_str(), false, useUTC, cls, preferredIdTypes, L"",
+    xmlparser xml;
+    xml.openMemoryOutput(false);
+    oe.exportIOFSplits(oEvent::IOF30, xml, false, useUTC, cls, preferredIdTypes, L"",
                        - 1, true, false, false, true, false, false);
-    ifstream fin(exportFile.c_str());
-    string rbf;
-    while (std::getline(fin, rbf)) {
-      answer += rbf;
-    }
-    removeTempFile(exportFile);
+    xml.closeOut();
+    xml.getMemoryOutput(answer);
     okRequest = true;
   }
   else if (what == "iofstart") {
-    wstring exportFile = getTempFile();
     bool useUTC = false;
     set<int> cls;
     if (param.count("class") > 0)
       getSelection(param.find("class")->second, cls);
     tuple<string, string, bool> preferredIdTypes("","",true);
 
-    oe.exportIOFStartlist(oEvent::IOF30, exportFile.c_str(), useUTC, cls, preferredIdTypes, false, true, false, false);
-    ifstream fin(exportFile.c_str());
-    string rbf;
-    while (std::getline(fin, rbf)) {
-      answer += rbf;
-    }
-    removeTempFile(exportFile);
+    xmlparser xml;
+    xml.openMemoryOutput(false);
+    oe.exportIOFStartlist(oEvent::IOF30, xml, useUTC, cls, preferredIdTypes, false, true, false, false);
+    xml.closeOut();
+    xml.getMemoryOutput(answer);
     okRequest = true;
   }
   else if (what == "competition") {
@@ -1099,6 +1606,10 @@ void RestServer::getStatistics(Statistics &s) {
   if (s.numRequests > 0) {
     s.averageResponseTime /= s.numRequests;
   }
+
+  s.endpoints.clear();
+  for (auto &cnt : endpointCounters)
+    s.endpoints.push_back({ cnt.first, cnt.second.hits, cnt.second.misses, cnt.second.notModified });
 }
 
 void RestServer::lookup(oEvent &oe, const string &what, const multimap<string, string> &param, string &answer) {
@@ -1680,3 +2191,75 @@ void RestServer::difference(oEvent &oe, int id, string &answer) {
     answer = "Error (MeOS): Unknown difference state. Use litteral 'zero' (?difference=zero) to get complete competition";
   }
 }
+
+void RestServer::resultEvents(oEvent &oe, int serial, string &answer) {
+  ResultEventLog &log = resultEventLog;
+  set<int> controls;
+  vector<pControl> ctrl;
+  oe.getControls(ctrl, false);
+  for (pControl c : ctrl)
+    controls.insert(c->getId());
+
+  vector<oEvent::ResultEventNotice> notices;
+  set<int> runners;
+  if (log.feedId > 0 && log.nameId == oe.getNameId(0) &&
+      oe.takeResultEventNotices(log.feedId, log.revision, notices) &&
+      oe.getResultEventRunners(notices, runners)) {
+    vector<oEvent::ResultEvent> runnerEvents;
+    oe.getResultEvents(runners, controls, runnerEvents);
+    for (auto &re : runnerEvents)
+      log.events.emplace_back(log.nextSerial++, re);
+
+    while (log.events.size() > maxLoggedResultEvents)
+      log.events.pop_front();
+  }
+  else {
+    // Unknown changes. All clients need a complete answer.
+    if (log.feedId == 0)
+      log.feedId = oe.subscribeResultEvents(set<int>(), int(maxLoggedResultEvents));
+    else
+      oe.takeResultEventNotices(log.feedId, log.revision, notices);
+    log.nameId = oe.getNameId(0);
+    log.revision = oe.getRevision();
+    log.events.clear();
+    log.completeSerial = ++log.nextSerial;
+  }
+
+  bool complete = serial < log.completeSerial || serial > log.nextSerial ||
+                  (!log.events.empty() && serial < log.events.front().first);
+
+  vector<oEvent::ResultEvent> allEvents;
+  if (complete) {
+    set<int> classes;
+    oe.getAllClasses(classes);
+    oe.getResultEvents(classes, controls, allEvents);
+  }
+
+  xmlparser mem;
+  mem.openMemoryOutput(false);
+  mem.startTag(complete ? "ResultEventsComplete" : "ResultEventsDiff",
+               { L"xmlns", L"http://www.melin.nu/mop", L"nextevents", itow(log.nextSerial) });
+
+  auto write = [&mem, &oe](const oEvent::ResultEvent &re) {
+    mem.write("Event", { make_pair("competitor", itow(re.r->getId())),
+                         make_pair("cls", itow(re.classId())),
+                         make_pair("leg", itow(re.leg())),
+                         make_pair("ctrl", itow(re.control)),
+                         make_pair("stat", itow(re.status)) }, 
+              re.time > 0 ? oe.getAbsTime(re.time) : L"");
+  };
+
+  if (complete) {
+    for (auto &re : allEvents)
+      write(re);
+  }
+  else {
+    // Events of a competitor replace earlier events of the same competitor
+    for (auto &re : log.events) {
+      if (re.first >= serial)
+        write(re.second);
+    }
+  }
+  mem.endTag();
+  mem.getMemoryOutput(answer);
+}
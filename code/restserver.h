@@ -53,6 +53,8 @@ private:
     EventRequest() : state(false) {}
     multimap<string, string> parameters;
     string answer;
+    string etag;
+    bool fromCache = false;
     vector<uint8_t> image;
     std::atomic_bool state; //false - asked, true - answerd
 
@@ -71,12 +73,81 @@ private:
   std::condition_variable waitForCompletion;
 
   deque<shared_ptr<EventRequest>> requests;
+
+  /** An answer computed for a data revision. The ETag is a hash of the answer.*/
+  struct CachedAnswer {
+    wstring nameId;
+    long revision = -1;
+    string answer;
+    string etag;
+
+    bool isCurrent(const oEvent &oe) const;
+  };
+
+  /** Answers to read-only requests, computed for one data revision. A published snapshot
+      is never modified, so it can be read by the service worker threads while the event
+      is being changed on the main thread.*/
+  struct Snapshot {
+    wstring nameId;
+    long revision = -1;
+    map<string, shared_ptr<const CachedAnswer>> answers;
+
+    bool isCurrent(const oEvent &oe) const;
+  };
+
+  struct ActiveQuery {
+    multimap<string, string> parameters;
+    uint64_t lastRequest = 0;
+    // Time the answer was last added to a snapshot
+    uint64_t lastBuilt = 0;
+  };
+
+  // Guards snapshot and activeQueries
+  std::mutex snapshotLock;
+  shared_ptr<const Snapshot> snapshot;
+  // Read-only queries recently asked. A query asked again since its answer was built
+  // is recomputed for the snapshot when data changes, one query at a time.
+  // At most maxActiveQueries, the least recently asked is dropped.
+  map<string, ActiveQuery> activeQueries;
+  uint64_t lastSnapshotUpdate = 0;
+  uint64_t lastServerCheck = 0;
+
+  /** Answers to cacheable requests by query key. Used on the main thread only.*/
+  map<string, shared_ptr<const CachedAnswer>> responseCache;
+
+  struct EndpointCounter {
+    int hits = 0;
+    int misses = 0;
+    int notModified = 0;
+  };
+  // Guarded by lock. Unknown endpoints share the entry "other".
+  map<string, EndpointCounter> endpointCounters;
+
+  static bool isReadOnly(const multimap<string, string> &param);
+  /** True if the answer depends only on the competition data.*/
+  static bool isCacheable(const multimap<string, string> &param);
+  static string getQueryKey(const multimap<string, string> &param);
+  static string getEndpoint(const multimap<string, string> &param);
+
+  static shared_ptr<const CachedAnswer> makeCachedAnswer(const oEvent &ref, string &&answer);
+  void addToResponseCache(const string &key, const shared_ptr<const CachedAnswer> &answer);
+
+  /** Look up the answer in the current snapshot. Called on a worker thread.
+      The snapshot is dropped by the main thread when the data changes.*/
+  shared_ptr<const CachedAnswer> getSnapshotAnswer(const multimap<string, string> &param);
+  /** Recompute active queries if the data revision changed. Called on the main thread.*/
+  void updateSnapshot(oEvent &ref);
+  /** Read changes from the server (as a client) before answering from cached data.*/
+  void synchronizeWithServer(oEvent &ref);
+  void addToSnapshot(oEvent &ref, const string &key, const shared_ptr<const CachedAnswer> &answer);
+
   void getData(oEvent &ref, const string &what, const multimap<string, string> &param, string &answer);
   void lookup(oEvent &ref, const string &what, const multimap<string, string> &param, string &answer);
   
   void newEntry(oEvent &ref, const multimap<string, string> &param, string &answer);
 
   void compute(oEvent &ref);
+  bool computeRequest(oEvent &ref, shared_ptr<EventRequest> &rq);
   void startThread(int port);
 
   static void getSelection(const string &param, set<int> &sel);
@@ -126,6 +197,22 @@ private:
 
   void difference(oEvent &oe, int id, string &answer);
 
+  /** Result events (radio punches and readouts) numbered by a serial, from an event feed.
+      Used on the main thread only.*/
+  struct ResultEventLog {
+    wstring nameId;
+    int feedId = 0;
+    long revision = -1;
+    int nextSerial = 1;
+    // Serials before this need a complete answer, since the feed was reset
+    int completeSerial = 1;
+    deque<pair<int, oEvent::ResultEvent>> events;
+  };
+  ResultEventLog resultEventLog;
+  static constexpr size_t maxLoggedResultEvents = 10000;
+
+  void resultEvents(oEvent &oe, int serial, string &answer);
+
 public:
 
   ~RestServer();
@@ -157,10 +244,18 @@ public:
     return std::make_tuple(epClass, epType);
   }
 
+  struct EndpointStatistics {
+    string endpoint;
+    int hits;
+    int misses;
+    int notModified;
+  };
+
   struct Statistics {
     int numRequests;
     int averageResponseTime;
     int maxResponseTime;
+    vector<EndpointStatistics> endpoints;
   };
 
   void getStatistics(Statistics &s);
@@ -23,7 +23,6 @@
 
 #include "stdafx.h"
 #include <fstream>
-#include <process.h>
 #include "socket.h"
 #include "meosexception.h"
 #include <iostream>
@@ -31,52 +30,73 @@
 //#define MEOS_DIRECT_PORT 21338
 
 
-DirectSocket::DirectSocket(int cmpId, int p) {
+DirectSocket::DirectSocket(int cmpId, int p) : messageQueue(new QueueSlot[queueSize]) {
   competitionId = cmpId;
   port = p;
-  InitializeCriticalSection(&syncObj);
   shutDown = false;
+  listening = false;
   sendSocket = -1;
   hDestinationWindow = 0;
-  clearQueue = false;
+  for (unsigned k = 0; k < queueSize; k++)
+    messageQueue[k].sequence.store(k, std::memory_order_relaxed);
+  enqueuePos = 0;
+  dequeuePos = 0;
+  notifyPending = false;
+  droppedPunches = 0;
 }
 
 DirectSocket::~DirectSocket() {
-  EnterCriticalSection(&syncObj);
   shutDown = true;
-  LeaveCriticalSection(&syncObj);
 
   if (sendSocket != -1) {
     closesocket(sendSocket);
     sendSocket = -1;
   }
 
-  Sleep(1000);
-  DeleteCriticalSection(&syncObj);
-  shutDown = true;
+  // The listener checks for shutdown at least every 200 ms
+  if (listenThread.joinable())
+    listenThread.join();
 }
 
-void DirectSocket::addPunchInfo(const SocketPunchInfo &pi) {
-  //OutputDebugString("Enter punch in queue\n");
-  EnterCriticalSection(&syncObj);
-  if (clearQueue)
-    messageQueue.clear();
-  clearQueue = false;
-  messageQueue.push_back(pi);
-  LeaveCriticalSection(&syncObj);
-  PostMessage(hDestinationWindow, WM_USER + 3, 0,0);
+bool DirectSocket::addPunchInfo(const SocketPunchInfo &pi) {
+  unsigned pos = enqueuePos.load(std::memory_order_relaxed);
+  while (true) {
+    QueueSlot &slot = messageQueue[pos & (queueSize - 1)];
+    unsigned seq = slot.sequence.load(std::memory_order_acquire);
+    int diff = int(seq - pos);
+    if (diff == 0) {
+      if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        slot.punch = pi;
+        slot.sequence.store(pos + 1, std::memory_order_release);
+        return true;
+      }
+    }
+    else if (diff < 0) {
+      // Full. The punch will be read from the database.
+      droppedPunches++;
+      return false;
+    }
+    else {
+      pos = enqueuePos.load(std::memory_order_relaxed);
+    }
+  }
 }
 
 void DirectSocket::getPunchQueue(vector<SocketPunchInfo> &pq) {
   pq.clear();
-
-  EnterCriticalSection(&syncObj);
-  if (!clearQueue)
-    pq.insert(pq.begin(), messageQueue.begin(), messageQueue.end());
-
-  clearQueue = true;
-  LeaveCriticalSection(&syncObj);
-  return;
+  // Clear before reading, so that punches added while reading give a new notification
+  notifyPending = false;
+
+  while (true) {
+    QueueSlot &slot = messageQueue[dequeuePos & (queueSize - 1)];
+    unsigned seq = slot.sequence.load(std::memory_order_acquire);
+    if (int(seq - (dequeuePos + 1)) < 0)
+      break; // Empty
+
+    pq.push_back(slot.punch);
+    slot.sequence.store(dequeuePos + queueSize, std::memory_order_release);
+    dequeuePos++;
+  }
 }
 
 void DirectSocket::listenDirectSocket() {
@@ -97,6 +117,11 @@ void DirectSocket::listenDirectSocket() {
     throw meosException("Socket error");
   }
 
+  // Non-blocking, to read all pending datagrams after each select
+  u_long nonBlocking = 1;
+  ioctlsocket(clientSocket, FIONBIO, &nonBlocking);
+
+  constexpr int maxBatch = 256;
   fd_set fds;
   struct timeval timeout;
   timeout.tv_sec = 0;
@@ -114,13 +139,23 @@ void DirectSocket::listenDirectSocket() {
     }
 
     if (rc > 0) {
-      ExtPunchInfo pi;
-      SOCKADDR_IN clientaddr;
-      int len = sizeof(clientaddr);
-      if (recvfrom(clientSocket, (char*)&pi, sizeof(pi), 0, (sockaddr*)&clientaddr, &len) > 0) {
-        if (pi.cmpId == competitionId)
-          addPunchInfo(pi.punch);
+      bool added = false;
+      for (int k = 0; k < maxBatch; k++) {
+        ExtPunchInfo pi;
+        SOCKADDR_IN clientaddr;
+        int len = sizeof(clientaddr);
+        if (recvfrom(clientSocket, (char*)&pi, sizeof(pi), 0, (sockaddr*)&clientaddr, &len) <= 0) {
+          if (WSAGetLastError() == WSAEMSGSIZE)
+            continue; // Not a punch
+          break;
+        }
+        if (pi.cmpId == competitionId && addPunchInfo(pi.punch))
+          added = true;
       }
+
+      // One notification per batch, and none while one is pending
+      if (added && !notifyPending.exchange(true))
+        PostMessage(hDestinationWindow, WM_USER + 3, 0, 0);
     }
   }
   closesocket(clientSocket);
@@ -143,6 +178,7 @@ void startListeningDirectSocket(void *p) {
   catch (...) {
     error = L"Unknown error";
   }
+  ((DirectSocket*)p)->listening = false;
   if (!error.empty()) {
     PostMessage(hWndMain, WM_USER + 5, 0, 0);
     //error = L"Setting up advance information service for punches failed. Punches will be recieved with some seconds delay. Is the network port blocked by an other MeOS session?\n\n" + error;
@@ -152,7 +188,12 @@ void startListeningDirectSocket(void *p) {
 
 void DirectSocket::startUDPSocketThread(HWND targetWindow) {
   hDestinationWindow = targetWindow;
-  _beginthread(startListeningDirectSocket, 0, this);
+  if (listening)
+    return;
+  if (listenThread.joinable())
+    listenThread.join(); // Stopped after an error
+  listening = true;
+  listenThread = std::thread(startListeningDirectSocket, this);
 }
 
 void DirectSocket::sendPunch(SocketPunchInfo &pi) {
@@ -20,8 +20,10 @@
 
 ************************************************************************/
 
-#include <list>
 #include <vector>
+#include <atomic>
+#include <memory>
+#include <thread>
 #include <winsock2.h>
 
 struct SocketPunchInfo {
@@ -46,23 +48,46 @@ private:
   };
 
   int competitionId;
-  list<SocketPunchInfo> messageQueue;
   HWND hDestinationWindow;
-  CRITICAL_SECTION syncObj;
-  volatile bool shutDown;
+  std::atomic<bool> shutDown;
   void listenDirectSocket();
-  void addPunchInfo(const SocketPunchInfo &pi);
-  bool startedUDPThread;
+  std::thread listenThread;
+  std::atomic<bool> listening;
+
+  /** Bounded lock-free queue of received punches. Many producers, one consumer.
+      Each slot has a sequence number telling if it is free for the producer at
+      position pos (sequence == pos) or filled for the consumer (sequence == pos + 1).*/
+  static constexpr unsigned queueSize = 4096; // Power of two
+  struct QueueSlot {
+    std::atomic<unsigned> sequence;
+    SocketPunchInfo punch;
+  };
+  unique_ptr<QueueSlot[]> messageQueue;
+  std::atomic<unsigned> enqueuePos;
+  unsigned dequeuePos;
+  // Set when the destination window has been notified, until the queue is read
+  std::atomic<bool> notifyPending;
+  std::atomic<int> droppedPunches;
+
+  /** Add a punch to the queue. Returns false if the queue is full.*/
+  bool addPunchInfo(const SocketPunchInfo &pi);
 
   SOCKET sendSocket;
-  bool clearQueue;
   int port;
 public:
 
   void startUDPSocketThread(HWND targetWindow);
   void sendPunchInfo(SocketPunchInfo &pi);
+  /** Take all received punches. Must be called from one thread only. */
   void getPunchQueue(vector<SocketPunchInfo> &queue);
 
+  /** Call when the WM_USER + 3 notification is handled, also if the queue is not read.
+      Punches received after this give a new notification. */
+  void notificationHandled() { notifyPending = false; }
+
+  /** Number of received punches dropped since the queue was full. */
+  int getDroppedPunches() const { return droppedPunches; }
+
   void sendPunch(SocketPunchInfo &pi);
 
   DirectSocket(int cmpId, int port);
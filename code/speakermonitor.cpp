@@ -47,11 +47,16 @@ SpeakerMonitor::SpeakerMonitor(oEvent &oe) : oe(oe) {
 }
 
 SpeakerMonitor::~SpeakerMonitor() {
+  if (feedId > 0)
+    oe.unsubscribeResultEvents(feedId);
 }
 
 void SpeakerMonitor::setClassFilter(const set<int> &filter, const set<int> &cfilter) {
   classFilter = filter;
   controlIdFilter = cfilter;
+  if (feedId > 0)
+    oe.unsubscribeResultEvents(feedId);
+  feedId = 0;
   oListInfo li;
   maxClassNameWidth = oe.gdiBase().scaleLength(li.getMaxCharWidth(oe, classFilter, EPostType::lClassName, -1, L"", gdiFonts::normalText));
 }
@@ -66,14 +71,9 @@ bool orderResultsInTime(const oEvent::ResultEvent &a,
   if (a.time != b.time)
     return a.time > b.time;
  
-  if (a.time > 0) {
-    const wstring &na = a.r->getName();
-    const wstring &nb = b.r->getName();
-  
-    return CompareString(LOCALE_USER_DEFAULT, 0,
-                          na.c_str(), na.length(),
-                          nb.c_str(), nb.length()) == CSTR_LESS_THAN;
-  }
+  if (a.time > 0)
+    return a.r->getNameKey() < b.r->getNameKey();
+
   return a.r->getId() < b.r->getId();
 }
 
@@ -84,7 +84,8 @@ void SpeakerMonitor::show(gdioutput &gdi) {
   extraWidth = gdi.scaleLength(200);
   dash = makeDash(L"- ");
 
-  oe.getResultEvents(classFilter, controlIdFilter, results);
+  updateResultEvents();
+  results = feedEvents;
   calculateResults();
 
   orderedResults.resize(results.size());
@@ -135,6 +136,36 @@ void SpeakerMonitor::show(gdioutput &gdi) {
   }
 }
 
+void SpeakerMonitor::updateResultEvents() {
+  if (classFilter.empty()) {
+    feedEvents.clear();
+    return;
+  }
+
+  vector<oEvent::ResultEventNotice> notices;
+  set<int> runners;
+  if (feedId > 0 && oe.takeResultEventNotices(feedId, feedRevision, notices) &&
+      oe.getResultEventRunners(notices, runners)) {
+    if (runners.empty())
+      return;
+
+    // Replace the events of the runners with new radio punches or readouts
+    feedEvents.erase(remove_if(feedEvents.begin(), feedEvents.end(), [&runners](const oEvent::ResultEvent &re) {
+      return runners.count(re.r->getId()) > 0;
+    }), feedEvents.end());
+
+    vector<oEvent::ResultEvent> runnerEvents;
+    oe.getResultEvents(runners, controlIdFilter, runnerEvents);
+    feedEvents.insert(feedEvents.end(), runnerEvents.begin(), runnerEvents.end());
+    return;
+  }
+
+  if (feedId == 0)
+    feedId = oe.subscribeResultEvents(classFilter, feedCapacity);
+  oe.getResultEvents(classFilter, controlIdFilter, feedEvents);
+  feedRevision = oe.getRevision();
+}
+
 bool SpeakerMonitor::sameResultPoint(const oEvent::ResultEvent &a,
                                      const oEvent::ResultEvent &b) {
   return a.control == b.control && a.classId() == b.classId() && a.leg() == b.leg();
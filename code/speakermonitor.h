@@ -78,6 +78,15 @@ private:
   vector<oEvent::ResultEvent> results;
   bool totalResults;
 
+  // Result events of the filter, kept up to date from the event feed
+  vector<oEvent::ResultEvent> feedEvents;
+  int feedId = 0;
+  long feedRevision = -1;
+  static constexpr int feedCapacity = 1024;
+
+  /** Update feedEvents with new radio punches and readouts.*/
+  void updateResultEvents();
+
   int placeLimit;
   int numLimit;
 
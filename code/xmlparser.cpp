@@ -25,7 +25,9 @@
 //////////////////////////////////////////////////////////////////////
 
 #include "stdafx.h"
+#include <thread>
 #include "xmlparser.h"
+#include "xmlscan.h"
 #include "meos_util.h"
 #include "progress.h"
 #include "meosexception.h"
@@ -55,7 +57,6 @@ xmlparser::xmlparser() : utfConverter(gdi_main)
 xmlparser::~xmlparser()
 {
   delete progress;
-  fin.close();
   foutFile.close();
 }
 
@@ -517,6 +518,25 @@ void xmlparser::getMemoryOutput(string &res) {
   foutString.clear();
 }
 
+void xmlparser::openFragmentOutput(bool useCutMode) {
+  cutMode = useCutMode;
+  toString = true;
+  tagStackPointer = 0;
+  foutString.str(string());
+  foutString.clear();
+}
+
+void xmlparser::takeFragment(string &fragment) {
+  fragment = foutString.str();
+  foutString.str(string());
+}
+
+void xmlparser::writeFragment(const string &fragment) {
+  fOut() << fragment;
+  if (!fOut().good())
+    throw meosException("Writing to XML file failed.");
+}
+
 void xmlparser::openOutput(const wchar_t *file, bool useCutMode)
 {
   openOutputT(file, useCutMode, "");
@@ -558,35 +578,88 @@ xmldata::xmldata(const char *t, char *d) : tag(t), data(d)
 {
   parent = -1;
   next = 0;
+  childTable = -1;
 }
 
 xmlattrib::xmlattrib(const char *t, char *d, const xmlparser *p) : tag(t), data(d), parser(p) {}
 
-void xmlparser::read(const wstring &file, int maxobj)
-{
-  fin.open(file.c_str(), ios::binary);
+namespace {
+  /** Read only memory mapped view of a file. */
+  class MappedFile {
+    HANDLE hFile = INVALID_HANDLE_VALUE;
+    HANDLE hMap = nullptr;
+    const char *view = nullptr;
+    size_t viewSize = 0;
+
+    void close() {
+      if (view)
+        UnmapViewOfFile(view);
+      if (hMap)
+        CloseHandle(hMap);
+      if (hFile != INVALID_HANDLE_VALUE)
+        CloseHandle(hFile);
+      view = nullptr;
+      hMap = nullptr;
+      hFile = INVALID_HANDLE_VALUE;
+    }
 
-  if (!fin.good())
-    throw meosException(L"Failed to open 'X' for reading.#" + file);
+  public:
+    MappedFile(const wstring &file) {
+      hFile = CreateFileW(file.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                          nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+      if (hFile == INVALID_HANDLE_VALUE)
+        throw meosException(L"Failed to open 'X' for reading.#" + file);
+
+      LARGE_INTEGER fileSize;
+      if (!GetFileSizeEx(hFile, &fileSize)) {
+        close();
+        throw meosException(L"Failed to open 'X' for reading.#" + file);
+      }
+      viewSize = size_t(fileSize.QuadPart);
+      if (viewSize == 0)
+        return; // Empty files cannot be mapped
 
-  char bf[1024];
-  bf[0]=0;
+      hMap = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (hMap)
+        view = (const char *)MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
 
-  do {
-    fin.getline(bf, 1024, '>');
-    lineNumber++;
+      if (view == nullptr) {
+        close();
+        throw meosException(L"Failed to open 'X' for reading.#" + file);
+      }
+    }
+
+    ~MappedFile() {
+      close();
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *data() const { return view; }
+    size_t size() const { return viewSize; }
+  };
+}
+
+size_t xmlparser::readHeader(const char *mem, size_t size) {
+  char bf[1024];
+  size_t i = 0;
+  size_t stop = min<size_t>(1020, size);
+  while (i < stop) {
+    bf[i] = mem[i];
+    if (mem[i++] == '>')
+      break;
   }
-  while(fin.good() && bf[0]==0);
+  bf[i] = 0;
 
-  char *ptr=ltrim(bf);
+  char *ptr = ltrim(bf);
   isUTF = checkUTF(ptr);
-  int p1 = (int)fin.tellg();
-
-  fin.seekg(0, ios::end);
-  int p2 = (int)fin.tellg();
-  fin.seekg(p1, ios::beg);
+  return i;
+}
 
-  int asize = p2-p1;
+void xmlparser::readBuffer(const char *mem, size_t size, int maxobj) {
+  size_t p1 = readHeader(mem, size);
+  int asize = int(size - p1);
   if (maxobj>0)
     asize = min(asize, maxobj*256);
 
@@ -599,51 +672,128 @@ void xmlparser::read(const wstring &file, int maxobj)
 
   parseStack.clear();
 
-  fin.read(&xbf[0], xbf.size());
+  if (asize > 0)
+    memcpy(&xbf[0], mem + p1, asize);
   xbf[asize] = 0;
 
-  fin.close();
-
   parse(maxobj);
 }
 
+void xmlparser::read(const wstring &file, int maxobj)
+{
+  MappedFile mf(file);
+  readBuffer(mf.data(), mf.size(), maxobj);
+}
+
 void xmlparser::readMemory(const string &mem, int maxobj)
 {
   if (mem.empty())
     return;
 
-  char bf[1024];
-  bf[0] = mem[0];
-  int i = 1;
-  int stop = min<int>(1020, mem.length());
-  while (i < stop && mem[i-1] != '>'){
-    bf[i] = mem[i];
-    i++;
-  }
-  bf[i] = 0;
-
-  char *ptr=ltrim(bf);
-  isUTF = checkUTF(ptr);
-  int p1 = i;
-  int p2 = mem.size();
+  readBuffer(mem.c_str(), mem.size(), maxobj);
+}
 
-  int asize = p2-p1;
-  if (maxobj>0)
-    asize = min(asize, maxobj*256);
+void xmlparser::readStream(const wstring &file, int recordDepth,
+                           const std::function<void(const xmlobject &)> &onRecord) {
+  MappedFile mf(file);
+  const char *mem = mf.data();
+  const size_t size = mf.size();
+  size_t pp = readHeader(mem, size);
 
-  if (progress && asize>80000)
+  if (progress && size > 80000)
     progress->init();
 
-  xbf.resize(asize+1);
-  xmlinfo.clear();
-  xmlinfo.reserve(xbf.size() / 30); // Guess number of tags
+  // Start tags [start, end) of open elements above record depth
+  vector<pair<size_t, size_t>> ancestors;
+  const size_t noRecord = -1;
+  size_t recordStart = noRecord;
+  size_t oldPrg = 0;
+  int depth = 0;
+
+  while (pp < size) {
+    const char *lt = scanForChar(mem + pp, mem + size, '<');
+    if (lt == mem + size)
+      break;
+    const size_t tagStart = lt - mem;
+    const char *gt = scanForChar(lt, mem + size, '>');
+    if (gt == mem + size)
+      break;
+    const size_t tagEnd = gt - mem + 1;
+    pp = tagEnd;
 
+    if (progress && (pp - oldPrg) > 50000) {
+      progress->setProgress(int(1000.0 * pp / size));
+      oldPrg = pp;
+    }
+
+    if (lt[1] == '!' || lt[1] == '?')
+      continue; // Comment or declaration
+
+    if (lt[1] == '/') {
+      if (--depth < 0)
+        throw std::exception("Invalid XML file.");
+
+      if (depth == recordDepth && recordStart != noRecord) {
+        parseRecord(mem, ancestors, recordStart, tagEnd, onRecord);
+        recordStart = noRecord;
+      }
+      else if (depth < recordDepth && !ancestors.empty())
+        ancestors.pop_back();
+    }
+    else {
+      bool onlyAttrib = gt[-1] == '/';
+      if (depth < recordDepth) {
+        if (!onlyAttrib)
+          ancestors.emplace_back(tagStart, tagEnd);
+      }
+      else if (depth == recordDepth) {
+        if (onlyAttrib)
+          parseRecord(mem, ancestors, tagStart, tagEnd, onRecord);
+        else
+          recordStart = tagStart;
+      }
+
+      if (!onlyAttrib)
+        depth++;
+    }
+  }
+
+  xbf.clear();
+  xbf.shrink_to_fit();
+  xmlinfo.clear();
   parseStack.clear();
+}
 
-  memcpy(&xbf[0], mem.c_str() + p1, xbf.size());
-  xbf[asize] = 0;
+void xmlparser::parseRecord(const char *mem, const vector<pair<size_t, size_t>> &ancestors,
+                            size_t recordStart, size_t recordEnd,
+                            const std::function<void(const xmlobject &)> &onRecord) {
+  xbf.clear();
+  for (auto &a : ancestors)
+    xbf.insert(xbf.end(), mem + a.first, mem + a.second);
 
-  parse(maxobj);
+  xbf.insert(xbf.end(), mem + recordStart, mem + recordEnd);
+
+  for (size_t k = ancestors.size(); k > 0; k--) {
+    const char *tag = mem + ancestors[k-1].first + 1;
+    const char *end = mem + ancestors[k-1].second - 1;
+    const char *tagEnd = tag;
+    while (tagEnd < end && !isBlankSpace(*tagEnd))
+      tagEnd++;
+
+    xbf.push_back('<');
+    xbf.push_back('/');
+    xbf.insert(xbf.end(), tag, tagEnd);
+    xbf.push_back('>');
+  }
+  xbf.push_back('\n');
+  xbf.push_back(0);
+
+  xmlinfo.clear();
+  parseStack.clear();
+  parse(0);
+
+  if (xmlinfo.size() > ancestors.size())
+    onRecord(xmlobject(this, ancestors.size()));
 }
 
 bool xmlparser::checkUTF(const char *ptr) const {
@@ -682,11 +832,22 @@ bool xmlparser::checkUTF(const char *ptr) const {
 
 bool xmlparser::parse(int maxobj) {
   lineNumber=0;
+  childTables.clear();
+
+  if (maxobj == 0) {
+    // Use one thread per MB, if available
+    const size_t bytesPerThread = 1024 * 1024;
+    int nThreads = min<int>(min<int>(std::thread::hardware_concurrency(), 16),
+                            int(xbf.size() / bytesPerThread));
+    if (nThreads > 1)
+      return parseParallel(nThreads);
+  }
+
   int oldPrg = -50001;
   int pp = 0;
   const int size = xbf.size()-2;
   while (pp < size) {
-    while (pp < size && xbf[pp] != '<') pp++;
+    pp = int(scanForChar(&xbf[pp], &xbf[0] + size, '<') - &xbf[0]);
 
     // Update progress while parsing
     if (progress && (pp - oldPrg)> 50000) {
@@ -698,7 +859,7 @@ bool xmlparser::parse(int maxobj) {
     if (xbf[pp] == '<') {
       xbf[pp] = 0;
       char *start = &xbf[pp+1];
-      while (pp < size && xbf[pp] != '>') pp++;
+      pp = int(scanForChar(&xbf[pp], &xbf[0] + size, '>') - &xbf[0]);
 
       if (xbf[pp] == '>') {
         xbf[pp] = 0;
@@ -722,7 +883,102 @@ bool xmlparser::parse(int maxobj) {
 
 void inplaceDecodeXML(char *in);
 
-bool xmlparser::processTag(char *start, char *end) {
+namespace {
+  /** Locate all tags starting in [first, last) and terminate tag and data by zero.
+      Tags are stored as (first character, last character before '>').*/
+  void tokenize(char *bf, size_t first, size_t last, size_t size,
+                vector<pair<char *, char *>> &tags) {
+    size_t pp = first;
+    while (pp < last) {
+      char *lt = const_cast<char *>(scanForChar(bf + pp, bf + last, '<'));
+      if (lt == bf + last)
+        break;
+      char *gt = const_cast<char *>(scanForChar(lt, bf + size, '>'));
+      if (gt == bf + size)
+        break;
+      *lt = 0;
+      *gt = 0;
+      tags.emplace_back(lt + 1, gt - 1);
+      pp = gt - bf + 1;
+    }
+  }
+
+  /** Decode the data following start tags. Must be called when all tags are zero terminated.*/
+  void decodeTagData(const vector<pair<char *, char *>> &tags) {
+    for (auto &t : tags) {
+      const char *start = t.first;
+      const char *end = t.second;
+      if (*start != '/' && *start != '!' && *end != '/')
+        inplaceDecodeXML(t.second + 2);
+    }
+  }
+}
+
+bool xmlparser::parseParallel(int nThreads) {
+  char *bf = xbf.data();
+  const size_t size = xbf.size() - 2;
+
+  // Split at tag boundaries
+  vector<size_t> bounds(nThreads + 1, size);
+  bounds[0] = 0;
+  for (int k = 1; k < nThreads; k++) {
+    size_t b = max(bounds[k-1], size * k / nThreads);
+    bounds[k] = scanForChar(bf + b, bf + size, '<') - bf;
+  }
+
+  vector<vector<pair<char *, char *>>> tags(nThreads);
+  vector<std::exception_ptr> errors(nThreads);
+  auto runPhase = [&](const std::function<void(int)> &phase) {
+    vector<std::thread> workers;
+    for (int k = 1; k < nThreads; k++) {
+      workers.emplace_back([&phase, &errors, k]() {
+        try {
+          phase(k);
+        }
+        catch (...) {
+          errors[k] = std::current_exception();
+        }
+      });
+    }
+    phase(0);
+    for (auto &w : workers)
+      w.join();
+    for (auto &e : errors) {
+      if (e)
+        std::rethrow_exception(e);
+    }
+  };
+
+  runPhase([&](int k) {
+    tags[k].reserve((bounds[k + 1] - bounds[k]) / 30);
+    tokenize(bf, bounds[k], bounds[k + 1], size, tags[k]);
+  });
+
+  if (progress)
+    progress->setProgress(250);
+
+  runPhase([&](int k) {
+    decodeTagData(tags[k]);
+  });
+
+  if (progress)
+    progress->setProgress(400);
+
+  // Build the element tree
+  for (auto &part : tags) {
+    for (auto &t : part) {
+      if (*t.first != '!')
+        processTag(t.first, t.second, false);
+    }
+    part.clear();
+    part.shrink_to_fit();
+  }
+
+  lastIndex = 0;
+  return true;
+}
+
+bool xmlparser::processTag(char *start, char *end, bool decodeData) {
   static char err[64];
   bool onlyAttrib = *end == '/';
   bool endTag = *start == '/';
@@ -746,7 +1002,8 @@ bool xmlparser::processTag(char *start, char *end) {
   else if (endTag) {
     if (!parseStack.empty()){
       xmldata &xd = xmlinfo[parseStack.back()];
-      inplaceDecodeXML(xd.data);
+      if (decodeData)
+        inplaceDecodeXML(xd.data);
       if (strcmp(tag, xd.tag)== 0) {
         parseStack.pop_back();
         xd.next = xmlinfo.size();
@@ -793,6 +1050,79 @@ const char * xmlparser::getError()
   return errorMessage.c_str();
 }*/
 
+unsigned xmlparser::hashTag(const char *tag) {
+  unsigned h = 2166136261u;
+  while (*tag) {
+    h ^= BYTE(*tag++);
+    h *= 16777619u;
+  }
+  return h;
+}
+
+int xmlparser::buildChildTable(int index) {
+  // Elements with few children are scanned linearly
+  const int linearLimit = 8;
+  int count = 0;
+  unsigned child = index+1;
+  while (child < xmlinfo.size() && xmlinfo[child].parent == index) {
+    count++;
+    child = xmlinfo[child].next;
+  }
+
+  if (count <= linearLimit)
+    return smallChildTable;
+
+  int tableSize = 16;
+  while (tableSize < 2 * count)
+    tableSize *= 2;
+
+  int offset = childTables.size();
+  childTables.resize(offset + 1 + tableSize, -1);
+  childTables[offset] = tableSize;
+  int *slots = &childTables[offset + 1];
+  const unsigned mask = tableSize - 1;
+
+  child = index+1;
+  while (child < xmlinfo.size() && xmlinfo[child].parent == index) {
+    const char *tag = xmlinfo[child].tag;
+    unsigned slot = hashTag(tag) & mask;
+    // Keep the first child with a given tag
+    while (slots[slot] != -1 && strcmp(xmlinfo[slots[slot]].tag, tag) != 0)
+      slot = (slot + 1) & mask;
+    if (slots[slot] == -1)
+      slots[slot] = child;
+    child = xmlinfo[child].next;
+  }
+  return offset;
+}
+
+int xmlparser::findChild(int index, const char *pname) {
+  int &table = xmlinfo[index].childTable;
+  if (table == noChildTable)
+    table = buildChildTable(index);
+
+  if (table == smallChildTable) {
+    unsigned child = index+1;
+    while (child < xmlinfo.size() && xmlinfo[child].parent == index) {
+      if (strcmp(xmlinfo[child].tag, pname)==0)
+        return child;
+      else
+        child = xmlinfo[child].next;
+    }
+    return -1;
+  }
+
+  const unsigned mask = childTables[table] - 1;
+  const int *slots = &childTables[table + 1];
+  unsigned slot = hashTag(pname) & mask;
+  while (slots[slot] != -1) {
+    if (strcmp(xmlinfo[slots[slot]].tag, pname) == 0)
+      return slots[slot];
+    slot = (slot + 1) & mask;
+  }
+  return -1;
+}
+
 xmlobject xmlobject::getObject(const char *pname) const
 {
   if (pname == 0)
@@ -800,17 +1130,12 @@ xmlobject xmlobject::getObject(const char *pname) const
   if (isnull())
     throw std::exception("Null pointer exception");
 
-  vector<xmldata> &xmlinfo = parser->xmlinfo;
-
   parser->access(index);
 
-  unsigned child = index+1;
-  while (child < xmlinfo.size() && xmlinfo[child].parent == index) {
-    if (strcmp(xmlinfo[child].tag, pname)==0)
-      return xmlobject(parser, child);
-    else
-      child = xmlinfo[child].next;
-  }
+  int child = parser->findChild(index, pname);
+  if (child >= 0)
+    return xmlobject(parser, child);
+
   return xmlobject(0);
 }
 
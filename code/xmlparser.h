@@ -27,6 +27,7 @@
 
 #include <vector>
 #include <sstream>
+#include <functional>
 class xmlobject;
 
 typedef vector<xmlobject> xmlList;
@@ -42,6 +43,9 @@ struct xmldata
   char *data;
   int parent;
   int next;
+  // Offset of the child lookup table in xmlparser::childTables,
+  // -1 if not yet built, -2 if the children are scanned linearly.
+  int childTable;
 };
 
 struct xmlattrib {
@@ -100,8 +104,6 @@ protected:
   std::ofstream foutFile;
   std::ostringstream foutString;
 
-  std::ifstream fin;
-
   std::ostream &fOut() {
     if (toString)
       return foutString;
@@ -116,11 +118,36 @@ protected:
   vector<xmldata> xmlinfo;
   vector<char> xbf;
 
-  bool processTag(char *start, char *end);
+  /** Open addressing tables for lookup of children by tag, built on first
+      lookup in elements with many children. Each table starts with its size (a power of two),
+      followed by the slots holding a child index or -1.*/
+  vector<int> childTables;
+  static const int noChildTable = -1;
+  static const int smallChildTable = -2;
+  static unsigned hashTag(const char *tag);
+  int buildChildTable(int index);
+  int findChild(int index, const char *pname);
+
+  bool processTag(char *start, char *end, bool decodeData = true);
 
   bool checkUTF(const char *ptr) const;
   bool parse(int maxobj);
 
+  /** Parse a large buffer in two phases. Tags are located and data decoded on
+      worker threads, each handling a part of the buffer. The element tree is then
+      built sequentially from the located tags.*/
+  bool parseParallel(int nThreads);
+
+  /** Check the header of a memory block and return the offset of the first byte after it.*/
+  size_t readHeader(const char *mem, size_t size);
+  void readBuffer(const char *mem, size_t size, int maxobj);
+
+  /** Parse a single record, with the start tags of its ancestors in [ancestors],
+      and pass it to the record handler.*/
+  void parseRecord(const char *mem, const vector<pair<size_t, size_t>> &ancestors,
+                   size_t recordStart, size_t recordEnd,
+                   const std::function<void(const xmlobject &)> &onRecord);
+
   void convertString(const char *in, char *out, int maxlen) const;
   void convertString(const char *in, wchar_t *out, int maxlen) const;
 
@@ -152,6 +179,14 @@ public:
   void read(const wstring &file, int maxobj = 0);
   void readMemory(const string &mem, int maxobj);
 
+  /** Read a file record by record without loading all of it into memory.
+      Each element at depth recordDepth (the root has depth 0) is parsed together
+      with the start tags of its ancestors and passed to onRecord. During the callback,
+      getObject(0) is the root element (holding only the current record).
+      Peak memory use is bounded by the largest record, not by the file size.*/
+  void readStream(const wstring &file, int recordDepth,
+                  const std::function<void(const xmlobject &)> &onRecord);
+
   void write(const char *tag, const char *prop,
               const string &value);
   void write(const char *tag, const char *prop,
@@ -207,6 +242,13 @@ public:
   void openMemoryOutput(bool useCutMode);
   void getMemoryOutput(string &res);
 
+  /** Write to memory without a header. The output is a fragment to be inserted into
+      another document by writeFragment.*/
+  void openFragmentOutput(bool useCutMode);
+  /** Get the output written since the last call and clear it.*/
+  void takeFragment(string &fragment);
+  void writeFragment(const string &fragment);
+
 
   const string &encodeXML(const string &input);
   const string &encodeXML(const wstring &input);
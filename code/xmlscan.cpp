@@ -0,0 +1,181 @@
+﻿/************************************************************************
+    MeOS - Orienteering Software
+    Copyright (C) 2009-2026 Melin Software HB
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Melin Software HB - software@melin.nu - www.melin.nu
+    Eksoppsvägen 16, SE-75646 UPPSALA, Sweden
+
+************************************************************************/
+
+#include "stdafx.h"
+#include "xmlscan.h"
+
+#if defined(_M_X64) || defined(_M_IX86)
+#define XMLSCAN_X86
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace {
+  inline bool isXMLEscape(char c) {
+    return c == '&' || c == '<' || c == '>' || c == '"' || c == '\n' || c == '\r' || c == 0;
+  }
+
+  const char *scanCharScalar(const char *begin, const char *end, char c) {
+    while (begin < end && *begin != c)
+      begin++;
+    return begin;
+  }
+
+  const char *scanEscapeScalar(const char *begin, const char *end) {
+    while (begin < end && !isXMLEscape(*begin))
+      begin++;
+    return begin;
+  }
+
+#ifdef XMLSCAN_X86
+  inline int firstBit(unsigned mask) {
+    unsigned long ix;
+    _BitScanForward(&ix, mask);
+    return int(ix);
+  }
+
+  const char *scanCharSSE2(const char *begin, const char *end, char c) {
+    const __m128i needle = _mm_set1_epi8(c);
+    while (end - begin >= 16) {
+      __m128i block = _mm_loadu_si128((const __m128i *)begin);
+      unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+      if (mask)
+        return begin + firstBit(mask);
+      begin += 16;
+    }
+    return scanCharScalar(begin, end, c);
+  }
+
+  const char *scanEscapeSSE2(const char *begin, const char *end) {
+    const __m128i amp = _mm_set1_epi8('&');
+    const __m128i lt = _mm_set1_epi8('<');
+    const __m128i gt = _mm_set1_epi8('>');
+    const __m128i quot = _mm_set1_epi8('"');
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i zero = _mm_setzero_si128();
+    while (end - begin >= 16) {
+      __m128i block = _mm_loadu_si128((const __m128i *)begin);
+      __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, amp), _mm_cmpeq_epi8(block, lt)),
+                                 _mm_or_si128(_mm_cmpeq_epi8(block, gt), _mm_cmpeq_epi8(block, quot)));
+      hit = _mm_or_si128(hit, _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, lf), _mm_cmpeq_epi8(block, cr)),
+                                           _mm_cmpeq_epi8(block, zero)));
+      unsigned mask = _mm_movemask_epi8(hit);
+      if (mask)
+        return begin + firstBit(mask);
+      begin += 16;
+    }
+    return scanEscapeScalar(begin, end);
+  }
+
+  const char *scanCharAVX2(const char *begin, const char *end, char c) {
+    const __m256i needle = _mm256_set1_epi8(c);
+    while (end - begin >= 32) {
+      __m256i block = _mm256_loadu_si256((const __m256i *)begin);
+      unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle));
+      if (mask)
+        return begin + firstBit(mask);
+      begin += 32;
+    }
+    return scanCharSSE2(begin, end, c);
+  }
+
+  const char *scanEscapeAVX2(const char *begin, const char *end) {
+    const __m256i amp = _mm256_set1_epi8('&');
+    const __m256i lt = _mm256_set1_epi8('<');
+    const __m256i gt = _mm256_set1_epi8('>');
+    const __m256i quot = _mm256_set1_epi8('"');
+    const __m256i lf = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i zero = _mm256_setzero_si256();
+    while (end - begin >= 32) {
+      __m256i block = _mm256_loadu_si256((const __m256i *)begin);
+      __m256i hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, amp), _mm256_cmpeq_epi8(block, lt)),
+                                    _mm256_or_si256(_mm256_cmpeq_epi8(block, gt), _mm256_cmpeq_epi8(block, quot)));
+      hit = _mm256_or_si256(hit, _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, lf), _mm256_cmpeq_epi8(block, cr)),
+                                                 _mm256_cmpeq_epi8(block, zero)));
+      unsigned mask = _mm256_movemask_epi8(hit);
+      if (mask)
+        return begin + firstBit(mask);
+      begin += 32;
+    }
+    return scanEscapeSSE2(begin, end);
+  }
+
+  bool hasSSE2() {
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+  }
+
+  bool hasAVX2() {
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+      return false;
+
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx)
+      return false;
+
+    // The operating system must save the YMM registers
+    if ((_xgetbv(0) & 6) != 6)
+      return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+  }
+#endif
+
+  struct ScanKernels {
+    const char *(*scanChar)(const char *, const char *, char) = scanCharScalar;
+    const char *(*scanEscape)(const char *, const char *) = scanEscapeScalar;
+
+    ScanKernels() {
+#ifdef XMLSCAN_X86
+      if (hasAVX2()) {
+        scanChar = scanCharAVX2;
+        scanEscape = scanEscapeAVX2;
+      }
+      else if (hasSSE2()) {
+        scanChar = scanCharSSE2;
+        scanEscape = scanEscapeSSE2;
+      }
+#endif
+    }
+  };
+
+  const ScanKernels &getKernels() {
+    static const ScanKernels kernels;
+    return kernels;
+  }
+}
+
+const char *scanForChar(const char *begin, const char *end, char c) {
+  return getKernels().scanChar(begin, end, c);
+}
+
+const char *scanForXMLEscape(const char *begin, const char *end) {
+  return getKernels().scanEscape(begin, end);
+}
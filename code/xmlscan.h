@@ -0,0 +1,32 @@
+﻿#pragma once
+/************************************************************************
+    MeOS - Orienteering Software
+    Copyright (C) 2009-2026 Melin Software HB
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Melin Software HB - software@melin.nu - www.melin.nu
+    Eksoppsvägen 16, SE-75646 UPPSALA, Sweden
+
+************************************************************************/
+
+// Vectorized scanning of XML text. SSE2 or AVX2 kernels are selected
+// at runtime depending on the processor, with a scalar fallback.
+
+/** Return a pointer to the first occurrence of c in [begin, end), or end.*/
+const char *scanForChar(const char *begin, const char *end, char c);
+
+/** Return a pointer to the first character in [begin, end) that must be encoded
+    by encodeXML (& < > " \n \r or zero), or end.*/
+const char *scanForXMLEscape(const char *begin, const char *end);